@@ -0,0 +1,151 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+
+namespace Smmalloc.Benchmarks {
+	// Time per operation and managed allocations of the native collections against List<T> and Dictionary<TKey, TValue>, the collections are rebuilt every round like per-tick containers
+	public static class NativeCollections {
+		private const int RoundsCount = 2000;
+		private const int ItemsCount = 1000;
+
+		private delegate void Round();
+
+		public static void Main() {
+			using (SmmallocInstance smmalloc = new SmmallocInstance(8, 16 * 1024 * 1024)) {
+				smmalloc.CreateThreadCache(64, CacheWarmupOptions.Hot);
+
+				Measure("List<int>", ListRound);
+				Measure("NativeList<int>", () => NativeListRound(smmalloc));
+				Measure("Dictionary<int, int>", DictionaryRound);
+				Measure("NativeHashMap<int, int>", () => NativeHashMapRound(smmalloc));
+
+				smmalloc.DestroyThreadCache();
+			}
+		}
+
+		private static void Measure(string name, Round round) {
+			// Warmup to get the code jitted and the pool buckets populated
+			for (int i = 0; i < RoundsCount / 10; i++) {
+				round();
+			}
+
+			// Managed allocations left for native collections are their wrapper objects
+			long allocatedBytes = GC.GetAllocatedBytesForCurrentThread();
+			int collectionsCount = GC.CollectionCount(0);
+			Stopwatch stopwatch = Stopwatch.StartNew();
+
+			for (int i = 0; i < RoundsCount; i++) {
+				round();
+			}
+
+			stopwatch.Stop();
+
+			double nanoseconds = stopwatch.Elapsed.TotalMilliseconds * 1000000.0 / ((double)RoundsCount * ItemsCount);
+
+			Console.WriteLine("{0,-24} {1,8:F2} ns per item {2,12} bytes allocated {3,6} collections", name, nanoseconds, GC.GetAllocatedBytesForCurrentThread() - allocatedBytes, GC.CollectionCount(0) - collectionsCount);
+		}
+
+		private static int sink;
+
+		private static void ListRound() {
+			List<int> list = new List<int>();
+
+			for (int i = 0; i < ItemsCount; i++) {
+				list.Add(i);
+			}
+
+			int sum = 0;
+
+			foreach (int item in list) {
+				sum += item;
+			}
+
+			sink += sum;
+		}
+
+		private static void NativeListRound(SmmallocInstance smmalloc) {
+			using (NativeList<int> list = new NativeList<int>(smmalloc)) {
+				for (int i = 0; i < ItemsCount; i++) {
+					list.Add(i);
+				}
+
+				int sum = 0;
+
+				foreach (int item in list) {
+					sum += item;
+				}
+
+				sink += sum;
+			}
+		}
+
+		private static void DictionaryRound() {
+			Dictionary<int, int> map = new Dictionary<int, int>();
+
+			for (int i = 0; i < ItemsCount; i++) {
+				map[i * 7] = i;
+			}
+
+			int sum = 0;
+
+			for (int i = 0; i < ItemsCount; i++) {
+				int value;
+
+				if (map.TryGetValue(i * 7, out value))
+					sum += value;
+			}
+
+			for (int i = 0; i < ItemsCount; i += 2) {
+				map.Remove(i * 7);
+			}
+
+			sink += sum;
+		}
+
+		private static void NativeHashMapRound(SmmallocInstance smmalloc) {
+			using (NativeHashMap<int, int> map = new NativeHashMap<int, int>(smmalloc)) {
+				for (int i = 0; i < ItemsCount; i++) {
+					map.Set(i * 7, i);
+				}
+
+				int sum = 0;
+
+				for (int i = 0; i < ItemsCount; i++) {
+					int value;
+
+					if (map.TryGetValue(i * 7, out value))
+						sum += value;
+				}
+
+				for (int i = 0; i < ItemsCount; i += 2) {
+					map.Remove(i * 7);
+				}
+
+				sink += sum;
+			}
+		}
+	}
+}
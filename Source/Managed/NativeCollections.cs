@@ -0,0 +1,609 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+using System.Collections.Generic;
+
+namespace Smmalloc {
+	internal static class NativeCollection {
+		// Pooled blocks fill the whole bucket element, usable size of fallback blocks is not reliable across platforms
+		internal static int GetUsableSize(SmmallocInstance smmalloc, IntPtr memory, int bytesCount) {
+			if (smmalloc.Bucket(memory) < 0)
+				return bytesCount;
+
+			return smmalloc.Size(memory);
+		}
+	}
+
+	public sealed unsafe class NativeList<T> : IDisposable where T : unmanaged {
+		private readonly SmmallocInstance smmalloc;
+		private T* buffer;
+		private int count;
+		private int capacity;
+
+		public NativeList(SmmallocInstance smmalloc) : this(smmalloc, 0) { }
+
+		public NativeList(SmmallocInstance smmalloc, int capacity) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (capacity < 0)
+				throw new ArgumentOutOfRangeException("capacity");
+
+			this.smmalloc = smmalloc;
+
+			if (capacity > 0)
+				Grow(capacity);
+		}
+
+		public void Dispose() {
+			if (buffer != null) {
+				smmalloc.Free((IntPtr)buffer);
+				buffer = null;
+			}
+
+			count = 0;
+			capacity = 0;
+		}
+
+		public int Count {
+			get {
+				return count;
+			}
+		}
+
+		public int Capacity {
+			get {
+				return capacity;
+			}
+		}
+
+		public ref T this[int index] {
+			get {
+				if (unchecked((uint)index >= (uint)count))
+					throw new ArgumentOutOfRangeException("index");
+
+				return ref buffer[index];
+			}
+		}
+
+		public void Add(T item) {
+			if (count == capacity)
+				Grow(count + 1);
+
+			buffer[count++] = item;
+		}
+
+		public void AddRange(ReadOnlySpan<T> items) {
+			if (count + items.Length > capacity)
+				Grow(count + items.Length);
+
+			items.CopyTo(new Span<T>(buffer + count, items.Length));
+			count += items.Length;
+		}
+
+		public void RemoveAt(int index) {
+			if (unchecked((uint)index >= (uint)count))
+				throw new ArgumentOutOfRangeException("index");
+
+			count--;
+
+			if (index < count)
+				new Span<T>(buffer + index + 1, count - index).CopyTo(new Span<T>(buffer + index, count - index));
+		}
+
+		public void RemoveAtSwapBack(int index) {
+			if (unchecked((uint)index >= (uint)count))
+				throw new ArgumentOutOfRangeException("index");
+
+			buffer[index] = buffer[--count];
+		}
+
+		public void Clear() {
+			count = 0;
+		}
+
+		public Span<T> AsSpan() {
+			return new Span<T>(buffer, count);
+		}
+
+		public Enumerator GetEnumerator() {
+			return new Enumerator(buffer, count);
+		}
+
+		private void Grow(int minCapacity) {
+			int newCapacity = Math.Max(Math.Max(capacity * 2, minCapacity), 4);
+			int bytesCapacity;
+			IntPtr memory = smmalloc.Grow((IntPtr)buffer, count * sizeof(T), checked(newCapacity * sizeof(T)), out bytesCapacity);
+
+			if (memory == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			buffer = (T*)memory;
+			capacity = bytesCapacity / sizeof(T);
+		}
+
+		public ref struct Enumerator {
+			private readonly T* buffer;
+			private readonly int count;
+			private int index;
+
+			internal Enumerator(T* buffer, int count) {
+				this.buffer = buffer;
+				this.count = count;
+				index = -1;
+			}
+
+			public bool MoveNext() {
+				return ++index < count;
+			}
+
+			public ref T Current {
+				get {
+					return ref buffer[index];
+				}
+			}
+		}
+	}
+
+	public sealed unsafe class NativeQueue<T> : IDisposable where T : unmanaged {
+		private readonly SmmallocInstance smmalloc;
+		private T* buffer;
+		private int head;
+		private int count;
+		private int capacity;
+
+		public NativeQueue(SmmallocInstance smmalloc) : this(smmalloc, 0) { }
+
+		public NativeQueue(SmmallocInstance smmalloc, int capacity) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (capacity < 0)
+				throw new ArgumentOutOfRangeException("capacity");
+
+			this.smmalloc = smmalloc;
+
+			if (capacity > 0)
+				Grow(capacity);
+		}
+
+		public void Dispose() {
+			if (buffer != null) {
+				smmalloc.Free((IntPtr)buffer);
+				buffer = null;
+			}
+
+			head = 0;
+			count = 0;
+			capacity = 0;
+		}
+
+		public int Count {
+			get {
+				return count;
+			}
+		}
+
+		public int Capacity {
+			get {
+				return capacity;
+			}
+		}
+
+		public void Enqueue(T item) {
+			if (count == capacity)
+				Grow(count + 1);
+
+			int tail = head + count;
+
+			if (tail >= capacity)
+				tail -= capacity;
+
+			buffer[tail] = item;
+			count++;
+		}
+
+		public bool TryDequeue(out T item) {
+			if (count == 0) {
+				item = default(T);
+
+				return false;
+			}
+
+			item = buffer[head];
+
+			if (++head == capacity)
+				head = 0;
+
+			count--;
+
+			return true;
+		}
+
+		public T Dequeue() {
+			T item;
+
+			if (!TryDequeue(out item))
+				throw new InvalidOperationException("Queue is empty");
+
+			return item;
+		}
+
+		public bool TryPeek(out T item) {
+			if (count == 0) {
+				item = default(T);
+
+				return false;
+			}
+
+			item = buffer[head];
+
+			return true;
+		}
+
+		public void Clear() {
+			head = 0;
+			count = 0;
+		}
+
+		public Enumerator GetEnumerator() {
+			return new Enumerator(buffer, head, count, capacity);
+		}
+
+		private void Grow(int minCapacity) {
+			int oldCapacity = capacity;
+			int newCapacity = Math.Max(Math.Max(capacity * 2, minCapacity), 4);
+			int bytesCapacity;
+
+			// Only the occupied extent of the ring is copied
+			IntPtr memory = smmalloc.Grow((IntPtr)buffer, Math.Min(head + count, oldCapacity) * sizeof(T), checked(newCapacity * sizeof(T)), out bytesCapacity);
+
+			if (memory == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			buffer = (T*)memory;
+			capacity = bytesCapacity / sizeof(T);
+
+			// Wrapped elements are moved after the old end to keep them contiguous with the head
+			int wrapped = head + count - oldCapacity;
+
+			if (wrapped > 0) {
+				if (oldCapacity + wrapped <= capacity) {
+					new Span<T>(buffer, wrapped).CopyTo(new Span<T>(buffer + oldCapacity, wrapped));
+				} else {
+					int headCount = oldCapacity - head;
+
+					new Span<T>(buffer + head, headCount).CopyTo(new Span<T>(buffer + capacity - headCount, headCount));
+					head = capacity - headCount;
+				}
+			}
+		}
+
+		public ref struct Enumerator {
+			private readonly T* buffer;
+			private readonly int head;
+			private readonly int count;
+			private readonly int capacity;
+			private int index;
+
+			internal Enumerator(T* buffer, int head, int count, int capacity) {
+				this.buffer = buffer;
+				this.head = head;
+				this.count = count;
+				this.capacity = capacity;
+				index = -1;
+			}
+
+			public bool MoveNext() {
+				return ++index < count;
+			}
+
+			public ref T Current {
+				get {
+					int position = head + index;
+
+					if (position >= capacity)
+						position -= capacity;
+
+					return ref buffer[position];
+				}
+			}
+		}
+	}
+
+	public sealed unsafe class NativeHashMap<TKey, TValue> : IDisposable where TKey : unmanaged, IEquatable<TKey> where TValue : unmanaged {
+		private const byte slotEmpty = 0;
+		private const byte slotFull = 1;
+		private const byte slotDeleted = 2;
+
+		private readonly SmmallocInstance smmalloc;
+		private TKey* keys;
+		private TValue* values;
+		private byte* states;
+		private int count;
+		private int deletedCount;
+		private int capacity;
+
+		public NativeHashMap(SmmallocInstance smmalloc) : this(smmalloc, 0) { }
+
+		public NativeHashMap(SmmallocInstance smmalloc, int capacity) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (capacity < 0)
+				throw new ArgumentOutOfRangeException("capacity");
+
+			this.smmalloc = smmalloc;
+
+			if (capacity > 0)
+				Resize(GetSlotsCount(capacity));
+		}
+
+		public void Dispose() {
+			Release(keys, values, states);
+
+			keys = null;
+			values = null;
+			states = null;
+			count = 0;
+			deletedCount = 0;
+			capacity = 0;
+		}
+
+		public int Count {
+			get {
+				return count;
+			}
+		}
+
+		public ref TValue this[TKey key] {
+			get {
+				int slot = Find(key);
+
+				if (slot < 0)
+					throw new KeyNotFoundException();
+
+				return ref values[slot];
+			}
+		}
+
+		public bool ContainsKey(TKey key) {
+			return Find(key) >= 0;
+		}
+
+		public bool TryGetValue(TKey key, out TValue value) {
+			int slot = Find(key);
+
+			if (slot < 0) {
+				value = default(TValue);
+
+				return false;
+			}
+
+			value = values[slot];
+
+			return true;
+		}
+
+		public bool TryAdd(TKey key, TValue value) {
+			if (Find(key) >= 0)
+				return false;
+
+			Insert(key, value);
+
+			return true;
+		}
+
+		public void Set(TKey key, TValue value) {
+			int slot = Find(key);
+
+			if (slot >= 0)
+				values[slot] = value;
+			else
+				Insert(key, value);
+		}
+
+		public bool Remove(TKey key) {
+			int slot = Find(key);
+
+			if (slot < 0)
+				return false;
+
+			states[slot] = slotDeleted;
+			count--;
+			deletedCount++;
+
+			return true;
+		}
+
+		public void Clear() {
+			if (states != null)
+				new Span<byte>(states, capacity).Clear();
+
+			count = 0;
+			deletedCount = 0;
+		}
+
+		public Enumerator GetEnumerator() {
+			return new Enumerator(keys, values, states, capacity);
+		}
+
+		private static int GetSlotsCount(int itemsCount) {
+			int slots = 8;
+
+			while (slots * 3 < checked(itemsCount * 4)) {
+				slots = checked(slots * 2);
+			}
+
+			return slots;
+		}
+
+		private static int GetSlot(TKey key, int mask) {
+			int hash = key.GetHashCode();
+
+			return (hash ^ (hash >> 16)) & mask;
+		}
+
+		private int Find(TKey key) {
+			if (count == 0)
+				return -1;
+
+			int mask = capacity - 1;
+			int slot = GetSlot(key, mask);
+
+			while (true) {
+				byte state = states[slot];
+
+				if (state == slotEmpty)
+					return -1;
+
+				if (state == slotFull && keys[slot].Equals(key))
+					return slot;
+
+				slot = (slot + 1) & mask;
+			}
+		}
+
+		private void Insert(TKey key, TValue value) {
+			if (capacity == 0 || (count + deletedCount + 1) * 4 > capacity * 3)
+				Resize(Math.Max(GetSlotsCount(count + 1), capacity));
+
+			int mask = capacity - 1;
+			int slot = GetSlot(key, mask);
+
+			while (states[slot] == slotFull) {
+				slot = (slot + 1) & mask;
+			}
+
+			if (states[slot] == slotDeleted)
+				deletedCount--;
+
+			keys[slot] = key;
+			values[slot] = value;
+			states[slot] = slotFull;
+			count++;
+		}
+
+		private void Resize(int newCapacity) {
+			TKey* oldKeys = keys;
+			TValue* oldValues = values;
+			byte* oldStates = states;
+			int oldCapacity = capacity;
+
+			TKey* newKeys = null;
+			TValue* newValues = null;
+			byte* newStates = null;
+
+			// The map stays intact if any of the blocks can't be allocated
+			try {
+				newKeys = (TKey*)Allocate(checked(newCapacity * sizeof(TKey)));
+				newValues = (TValue*)Allocate(checked(newCapacity * sizeof(TValue)));
+				newStates = (byte*)Allocate(newCapacity);
+			} catch {
+				Release(newKeys, newValues, newStates);
+
+				throw;
+			}
+
+			keys = newKeys;
+			values = newValues;
+			states = newStates;
+			new Span<byte>(states, newCapacity).Clear();
+			capacity = newCapacity;
+			count = 0;
+			deletedCount = 0;
+
+			int mask = capacity - 1;
+
+			for (int i = 0; i < oldCapacity; i++) {
+				if (oldStates[i] != slotFull)
+					continue;
+
+				int slot = GetSlot(oldKeys[i], mask);
+
+				while (states[slot] != slotEmpty) {
+					slot = (slot + 1) & mask;
+				}
+
+				keys[slot] = oldKeys[i];
+				values[slot] = oldValues[i];
+				states[slot] = slotFull;
+				count++;
+			}
+
+			Release(oldKeys, oldValues, oldStates);
+		}
+
+		private IntPtr Allocate(int bytesCount) {
+			IntPtr memory = smmalloc.MallocUnsafe(bytesCount);
+
+			if (memory == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			return memory;
+		}
+
+		private void Release(TKey* keys, TValue* values, byte* states) {
+			if (keys != null)
+				smmalloc.Free((IntPtr)keys);
+
+			if (values != null)
+				smmalloc.Free((IntPtr)values);
+
+			if (states != null)
+				smmalloc.Free((IntPtr)states);
+		}
+
+		public ref struct Enumerator {
+			private readonly TKey* keys;
+			private readonly TValue* values;
+			private readonly byte* states;
+			private readonly int capacity;
+			private int index;
+
+			internal Enumerator(TKey* keys, TValue* values, byte* states, int capacity) {
+				this.keys = keys;
+				this.values = values;
+				this.states = states;
+				this.capacity = capacity;
+				index = -1;
+			}
+
+			public bool MoveNext() {
+				while (++index < capacity) {
+					if (states[index] == slotFull)
+						return true;
+				}
+
+				return false;
+			}
+
+			public KeyValuePair<TKey, TValue> Current {
+				get {
+					return new KeyValuePair<TKey, TValue>(keys[index], values[index]);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,70 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+using System.Buffers;
+
+namespace Smmalloc {
+	internal sealed unsafe class NativeMemoryManager : MemoryManager<byte> {
+		private byte* pointer;
+		private int length;
+
+		public NativeMemoryManager(IntPtr pointer, int length) {
+			this.pointer = (byte*)pointer;
+			this.length = length;
+		}
+
+		public override Span<byte> GetSpan() {
+			return new Span<byte>(pointer, length);
+		}
+
+		public override MemoryHandle Pin(int elementIndex = 0) {
+			if (elementIndex < 0 || elementIndex > length)
+				throw new ArgumentOutOfRangeException("elementIndex");
+
+			return new MemoryHandle(pointer + elementIndex);
+		}
+
+		public override void Unpin() { }
+
+		protected override void Dispose(bool disposing) {
+			pointer = null;
+			length = 0;
+		}
+	}
+
+	internal sealed class NativeSequenceSegment : ReadOnlySequenceSegment<byte> {
+		public NativeSequenceSegment(ReadOnlyMemory<byte> memory, long runningIndex) {
+			Memory = memory;
+			RunningIndex = runningIndex;
+		}
+
+		public NativeSequenceSegment Append(ReadOnlyMemory<byte> memory) {
+			NativeSequenceSegment segment = new NativeSequenceSegment(memory, RunningIndex + Memory.Length);
+
+			Next = segment;
+
+			return segment;
+		}
+	}
+}
@@ -22,31 +22,85 @@
  */
 
 using System;
+using System.Collections.Generic;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Security;
+using System.Threading;
 
 namespace Smmalloc {
 	public enum CacheWarmupOptions {
 		Cold = 0,
 		Warm = 1,
-		Hot = 2
+		Hot = 2,
+		Reserved = 3
+	}
+
+	[Flags]
+	public enum AllocatorOptions {
+		Default = 0,
+		Memfd = 1 << 0,
+		Prefault = 1 << 1,
+		ParallelInit = 1 << 2,
+		Locked = 1 << 3,
+		NoFallback = 1 << 4,
+		TinyClasses = 1 << 5,
+		WipeOnFree = 1 << 6
+	}
+
+	[StructLayout(LayoutKind.Sequential)]
+	public struct IoVec {
+		public IntPtr Base;
+		public IntPtr Length;
+	}
+
+	public struct ThreadCacheScope : IDisposable {
+		private SmmallocInstance smmalloc;
+
+		internal ThreadCacheScope(SmmallocInstance smmalloc) {
+			this.smmalloc = smmalloc;
+		}
+
+		public void Dispose() {
+			if (smmalloc != null) {
+				smmalloc.DestroyThreadCache();
+				smmalloc = null;
+			}
+		}
 	}
 
 	public class SmmallocInstance : IDisposable {
 		private IntPtr nativeAllocator;
 		private readonly uint allocationLimit;
+		private readonly long instanceId;
+		private int threadCacheSize = 256;
+		private CacheWarmupOptions threadCacheWarmup = CacheWarmupOptions.Cold;
+		private static long instancesCount;
+		private static readonly HashSet<long> liveInstances = new HashSet<long>();
+		[ThreadStatic]
+		private static long threadCacheOwner;
+
+		public SmmallocInstance(uint bucketsCount, int bucketSize) : this(bucketsCount, (long)bucketSize, AllocatorOptions.Default) { }
+
+		public SmmallocInstance(uint bucketsCount, int bucketSize, AllocatorOptions options) : this(bucketsCount, (long)bucketSize, options) { }
 
-		public SmmallocInstance(uint bucketsCount, int bucketSize) {
+		public SmmallocInstance(uint bucketsCount, long bucketSize) : this(bucketsCount, bucketSize, AllocatorOptions.Default) { }
+
+		public SmmallocInstance(uint bucketsCount, long bucketSize, AllocatorOptions options) {
 			if (bucketsCount > 64)
 				throw new ArgumentOutOfRangeException();
 
-			nativeAllocator = Native.sm_allocator_create(bucketsCount, (IntPtr)bucketSize);
+			nativeAllocator = Native.sm_allocator_create_ex(bucketsCount, (IntPtr)bucketSize, options);
 
 			if (nativeAllocator == IntPtr.Zero)
 				throw new InvalidOperationException("Native memory allocator not created");
 
 			allocationLimit = bucketsCount * 16;
+			instanceId = Interlocked.Increment(ref instancesCount);
+
+			lock (liveInstances) {
+				liveInstances.Add(instanceId);
+			}
 		}
 
 		public void Dispose() {
@@ -56,8 +110,15 @@ namespace Smmalloc {
 
 		protected virtual void Dispose(bool disposing) {
 			if (nativeAllocator != IntPtr.Zero) {
+				lock (liveInstances) {
+					liveInstances.Remove(instanceId);
+				}
+
 				Native.sm_allocator_destroy(nativeAllocator);
 				nativeAllocator = IntPtr.Zero;
+
+				if (threadCacheOwner == instanceId)
+					threadCacheOwner = 0;
 			}
 		}
 
@@ -65,15 +126,155 @@ namespace Smmalloc {
 			Dispose(false);
 		}
 
+		internal IntPtr NativeAllocator {
+			get {
+				return nativeAllocator;
+			}
+		}
+
+		internal int AllocationLimit {
+			get {
+				return (int)allocationLimit;
+			}
+		}
+
+		public int ThreadCacheSize {
+			get {
+				return threadCacheSize;
+			}
+
+			set {
+				if (value <= 0)
+					throw new ArgumentOutOfRangeException("value");
+
+				threadCacheSize = value;
+			}
+		}
+
+		public CacheWarmupOptions ThreadCacheWarmup {
+			get {
+				return threadCacheWarmup;
+			}
+
+			set {
+				threadCacheWarmup = value;
+			}
+		}
+
 		public void CreateThreadCache(int cacheSize, CacheWarmupOptions warmupOption) {
 			if (cacheSize == 0 || cacheSize < 0)
 				throw new ArgumentOutOfRangeException();
 
-			Native.sm_allocator_thread_cache_create(nativeAllocator, warmupOption, (IntPtr)cacheSize);
+			threadCacheOwner = Native.sm_allocator_thread_cache_create(nativeAllocator, warmupOption, (IntPtr)cacheSize) ? instanceId : 0;
+		}
+
+		public void CreateThreadCache(int cacheSize, CacheWarmupOptions warmupOption, ulong bucketsMask) {
+			if (cacheSize == 0 || cacheSize < 0)
+				throw new ArgumentOutOfRangeException("cacheSize");
+
+			// A mask without buckets of the instance leaves the thread without cache
+			threadCacheOwner = Native.sm_allocator_thread_cache_create_ex(nativeAllocator, warmupOption, (IntPtr)cacheSize, bucketsMask) ? instanceId : 0;
+		}
+
+		public void CreateThreadCacheAsync(int cacheSize, CacheWarmupOptions warmupOption) {
+			if (cacheSize == 0 || cacheSize < 0)
+				throw new ArgumentOutOfRangeException("cacheSize");
+
+			threadCacheOwner = Native.sm_allocator_thread_cache_create_async(nativeAllocator, warmupOption, (IntPtr)cacheSize) ? instanceId : 0;
+		}
+
+		public void CreateThreadCacheAsync(int cacheSize, CacheWarmupOptions warmupOption, ulong bucketsMask) {
+			if (cacheSize == 0 || cacheSize < 0)
+				throw new ArgumentOutOfRangeException("cacheSize");
+
+			threadCacheOwner = Native.sm_allocator_thread_cache_create_async_ex(nativeAllocator, warmupOption, (IntPtr)cacheSize, bucketsMask) ? instanceId : 0;
+		}
+
+		public void CreateThreadCacheAsync(int[] cacheSizes, CacheWarmupOptions warmupOption) {
+			if (cacheSizes == null)
+				throw new ArgumentNullException("cacheSizes");
+
+			for (int i = 0; i < cacheSizes.Length; i++) {
+				if (cacheSizes[i] < 0)
+					throw new ArgumentOutOfRangeException("cacheSizes");
+			}
+
+			threadCacheOwner = Native.sm_allocator_thread_cache_create_async_sizes(nativeAllocator, warmupOption, cacheSizes, (uint)cacheSizes.Length) ? instanceId : 0;
+		}
+
+		public void CreateThreadCache(int[] cacheSizes, CacheWarmupOptions warmupOption) {
+			if (cacheSizes == null)
+				throw new ArgumentNullException("cacheSizes");
+
+			for (int i = 0; i < cacheSizes.Length; i++) {
+				if (cacheSizes[i] < 0)
+					throw new ArgumentOutOfRangeException("cacheSizes");
+			}
+
+			threadCacheOwner = Native.sm_allocator_thread_cache_create_sizes(nativeAllocator, warmupOption, cacheSizes, (uint)cacheSizes.Length) ? instanceId : 0;
 		}
 
 		public void DestroyThreadCache() {
 			Native.sm_allocator_thread_cache_destroy(nativeAllocator);
+			threadCacheOwner = 0;
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool EnsureThreadCache() {
+			if (threadCacheOwner == instanceId)
+				return true;
+
+			return EnsureThreadCacheSlow(threadCacheSize, threadCacheWarmup);
+		}
+
+		public bool EnsureThreadCache(int cacheSize, CacheWarmupOptions warmupOption) {
+			if (threadCacheOwner == instanceId)
+				return true;
+
+			return EnsureThreadCacheSlow(cacheSize, warmupOption);
+		}
+
+		private bool EnsureThreadCacheSlow(int cacheSize, CacheWarmupOptions warmupOption) {
+			// A cache left by a disposed instance is replaced, the native side drops it
+			if (threadCacheOwner != 0 && IsLiveInstance(threadCacheOwner))
+				return false;
+
+			CreateThreadCache(cacheSize, warmupOption);
+
+			return threadCacheOwner == instanceId;
+		}
+
+		private static bool IsLiveInstance(long id) {
+			lock (liveInstances) {
+				return liveInstances.Contains(id);
+			}
+		}
+
+		public ThreadCacheScope CreateThreadCacheScope() {
+			return CreateThreadCacheScope(threadCacheSize, threadCacheWarmup);
+		}
+
+		public ThreadCacheScope CreateThreadCacheScope(int cacheSize, CacheWarmupOptions warmupOption) {
+			if (threadCacheOwner == instanceId || !EnsureThreadCacheSlow(cacheSize, warmupOption))
+				return new ThreadCacheScope();
+
+			return new ThreadCacheScope(this);
+		}
+
+		public Thread CreateThread(ThreadStart start) {
+			if (start == null)
+				throw new ArgumentNullException("start");
+
+			int cacheSize = threadCacheSize;
+			CacheWarmupOptions warmupOption = threadCacheWarmup;
+
+			return new Thread(() => {
+				using (CreateThreadCacheScope(cacheSize, warmupOption)) {
+					start();
+				}
+			});
 		}
 
 		#if SMMALLOC_INLINING
@@ -93,6 +294,43 @@ namespace Smmalloc {
 			return Native.sm_malloc(nativeAllocator, (IntPtr)bytesCount, (IntPtr)alignment);
 		}
 
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool TryMalloc(int bytesCount, out IntPtr memory) {
+			return TryMalloc(bytesCount, 0, out memory);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool TryMalloc(int bytesCount, int alignment, out IntPtr memory) {
+			// A single unsigned comparison rejects both zero and negative sizes
+			if (unchecked((uint)bytesCount - 1) >= int.MaxValue) {
+				memory = IntPtr.Zero;
+
+				return false;
+			}
+
+			memory = Native.sm_malloc(nativeAllocator, (IntPtr)bytesCount, (IntPtr)alignment);
+
+			return memory != IntPtr.Zero;
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public IntPtr MallocUnsafe(int bytesCount) {
+			return Native.sm_malloc(nativeAllocator, (IntPtr)bytesCount, IntPtr.Zero);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public IntPtr MallocUnsafe(int bytesCount, int alignment) {
+			return Native.sm_malloc(nativeAllocator, (IntPtr)bytesCount, (IntPtr)alignment);
+		}
+
 		#if SMMALLOC_INLINING
 			[MethodImpl(256)]
 		#endif
@@ -103,6 +341,16 @@ namespace Smmalloc {
 			Native.sm_free(nativeAllocator, memory);
 		}
 
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public void FreeWipe(IntPtr memory) {
+			if (memory == IntPtr.Zero)
+				throw new ArgumentNullException("memory");
+
+			Native.sm_free_wipe(nativeAllocator, memory);
+		}
+
 		#if SMMALLOC_INLINING
 			[MethodImpl(256)]
 		#endif
@@ -143,6 +391,83 @@ namespace Smmalloc {
 			return Native.sm_realloc(nativeAllocator, memory, (IntPtr)bytesCount, (IntPtr)alignment);
 		}
 
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool TryRealloc(IntPtr memory, int bytesCount, out IntPtr result) {
+			return TryRealloc(memory, bytesCount, 0, out result);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool TryRealloc(IntPtr memory, int bytesCount, int alignment, out IntPtr result) {
+			if (unchecked((uint)bytesCount - 1) >= int.MaxValue) {
+				result = IntPtr.Zero;
+
+				return false;
+			}
+
+			result = Native.sm_realloc(nativeAllocator, memory, (IntPtr)bytesCount, (IntPtr)alignment);
+
+			return result != IntPtr.Zero;
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public IntPtr ReallocUnsafe(IntPtr memory, int bytesCount) {
+			return Native.sm_realloc(nativeAllocator, memory, (IntPtr)bytesCount, IntPtr.Zero);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public IntPtr ReallocUnsafe(IntPtr memory, int bytesCount, int alignment) {
+			return Native.sm_realloc(nativeAllocator, memory, (IntPtr)bytesCount, (IntPtr)alignment);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool Expand(IntPtr memory, int bytesCount) {
+			if (memory == IntPtr.Zero)
+				throw new ArgumentNullException("memory");
+
+			if (bytesCount <= 0 || bytesCount > allocationLimit)
+				throw new ArgumentOutOfRangeException();
+
+			return Native.sm_expand(nativeAllocator, memory, (IntPtr)bytesCount) != IntPtr.Zero;
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public int GoodSize(int bytesCount) {
+			if (bytesCount < 0)
+				throw new ArgumentOutOfRangeException();
+
+			return (int)Native.sm_good_size(nativeAllocator, (IntPtr)bytesCount);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public IntPtr Grow(IntPtr memory, int usedBytes, int bytesCount, out int capacity) {
+			if (bytesCount <= 0)
+				throw new ArgumentOutOfRangeException("bytesCount");
+
+			if (usedBytes < 0 || usedBytes > bytesCount || (memory == IntPtr.Zero && usedBytes > 0))
+				throw new ArgumentOutOfRangeException("usedBytes");
+
+			IntPtr usableBytes;
+			IntPtr result = Native.sm_grow(nativeAllocator, memory, (IntPtr)usedBytes, (IntPtr)bytesCount, out usableBytes);
+
+			capacity = result != IntPtr.Zero ? (int)usableBytes : 0;
+
+			return result;
+		}
+
 		#if SMMALLOC_INLINING
 			[MethodImpl(256)]
 		#endif
@@ -162,6 +487,115 @@ namespace Smmalloc {
 
 			return Native.sm_mbucket(nativeAllocator, memory);
 		}
+
+		public int ArenaDescriptor(out long arenaSize) {
+			IntPtr size;
+			int fd = Native.sm_allocator_arena_fd(nativeAllocator, out size);
+
+			arenaSize = (long)size;
+
+			return fd;
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool Block(IntPtr memory, out int fd, out long offset, out int length) {
+			if (memory == IntPtr.Zero)
+				throw new ArgumentNullException("memory");
+
+			IntPtr position, size;
+
+			if (!Native.sm_mblock(nativeAllocator, memory, out fd, out position, out size)) {
+				fd = -1;
+				offset = 0;
+				length = 0;
+
+				return false;
+			}
+
+			offset = (long)position;
+			length = (int)size;
+
+			return true;
+		}
+
+		public bool RegisterIoBuffers(int ringFd) {
+			return RegisterIoBuffers(ringFd, ulong.MaxValue);
+		}
+
+		public bool RegisterIoBuffers(int ringFd, ulong bucketsMask) {
+			if (ringFd < 0)
+				throw new ArgumentOutOfRangeException("ringFd");
+
+			return Native.sm_allocator_io_register(nativeAllocator, ringFd, bucketsMask);
+		}
+
+		public bool UnregisterIoBuffers() {
+			return Native.sm_allocator_io_unregister(nativeAllocator);
+		}
+
+		#if SMMALLOC_INLINING
+			[MethodImpl(256)]
+		#endif
+		public bool IoBuffer(IntPtr memory, out int bufferIndex, out long offset) {
+			if (memory == IntPtr.Zero)
+				throw new ArgumentNullException("memory");
+
+			uint index;
+			IntPtr position;
+
+			if (!Native.sm_mbuffer(nativeAllocator, memory, out index, out position)) {
+				bufferIndex = -1;
+				offset = 0;
+
+				return false;
+			}
+
+			bufferIndex = (int)index;
+			offset = (long)position;
+
+			return true;
+		}
+
+		public ulong MallocHandle(int bytesCount) {
+			if (bytesCount < 0)
+				throw new ArgumentOutOfRangeException("bytesCount");
+
+			ulong handle = Native.sm_halloc(nativeAllocator, (IntPtr)bytesCount);
+
+			if (handle == 0)
+				throw new OutOfMemoryException();
+
+			return handle;
+		}
+
+		public void FreeHandle(ulong handle) {
+			Native.sm_hfree(nativeAllocator, handle);
+		}
+
+		public IntPtr LockHandle(ulong handle) {
+			return Native.sm_hlock(nativeAllocator, handle);
+		}
+
+		public void UnlockHandle(ulong handle) {
+			Native.sm_hunlock(nativeAllocator, handle);
+		}
+
+		public int HandleSize(ulong handle) {
+			return (int)Native.sm_hsize(nativeAllocator, handle);
+		}
+
+		public long Compact() {
+			return (long)Native.sm_compact(nativeAllocator, 0);
+		}
+
+		public long Compact(TimeSpan budget) {
+			if (budget <= TimeSpan.Zero)
+				throw new ArgumentOutOfRangeException("budget");
+
+			return (long)Native.sm_compact(nativeAllocator, (ulong)Math.Max(budget.Ticks / 10, 1));
+		}
 	}
 
 	[SuppressUnmanagedCodeSecurity]
@@ -171,11 +605,35 @@ namespace Smmalloc {
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern IntPtr sm_allocator_create(uint bucketsCount, IntPtr bucketSizeInBytes);
 
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_allocator_create_ex(uint bucketsCount, IntPtr bucketSizeInBytes, AllocatorOptions options);
+
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern void sm_allocator_destroy(IntPtr allocator);
 
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
-		internal static extern void sm_allocator_thread_cache_create(IntPtr allocator, CacheWarmupOptions warmupOption, IntPtr cacheSize);
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_thread_cache_create(IntPtr allocator, CacheWarmupOptions warmupOption, IntPtr cacheSize);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_thread_cache_create_ex(IntPtr allocator, CacheWarmupOptions warmupOption, IntPtr cacheSize, ulong bucketsMask);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_thread_cache_create_sizes(IntPtr allocator, CacheWarmupOptions warmupOption, int[] cacheSizes, uint cacheSizesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_thread_cache_create_async(IntPtr allocator, CacheWarmupOptions warmupOption, IntPtr cacheSize);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_thread_cache_create_async_ex(IntPtr allocator, CacheWarmupOptions warmupOption, IntPtr cacheSize, ulong bucketsMask);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_thread_cache_create_async_sizes(IntPtr allocator, CacheWarmupOptions warmupOption, int[] cacheSizes, uint cacheSizesCount);
 
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern void sm_allocator_thread_cache_destroy(IntPtr allocator);
@@ -186,6 +644,9 @@ namespace Smmalloc {
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern void sm_free(IntPtr allocator, IntPtr memory);
 
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern void sm_free_wipe(IntPtr allocator, IntPtr memory);
+
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern void sm_free_batch(IntPtr allocator, IntPtr batch, IntPtr length);
 
@@ -195,10 +656,87 @@ namespace Smmalloc {
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern IntPtr sm_realloc(IntPtr allocator, IntPtr memory, IntPtr bytesCount, IntPtr alignment);
 
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_expand(IntPtr allocator, IntPtr memory, IntPtr bytesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_good_size(IntPtr allocator, IntPtr bytesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_grow(IntPtr allocator, IntPtr memory, IntPtr usedBytes, IntPtr bytesCount, out IntPtr capacity);
+
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern IntPtr sm_msize(IntPtr allocator, IntPtr memory);
 
 		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
 		internal static extern int sm_mbucket(IntPtr allocator, IntPtr memory);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern int sm_allocator_arena_fd(IntPtr allocator, out IntPtr arenaSize);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_mblock(IntPtr allocator, IntPtr memory, out int fd, out IntPtr offset, out IntPtr length);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_io_register(IntPtr allocator, int ringFd, ulong bucketsMask);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_allocator_io_unregister(IntPtr allocator);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_mbuffer(IntPtr allocator, IntPtr memory, out uint bufferIndex, out IntPtr offset);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern ulong sm_halloc(IntPtr allocator, IntPtr bytesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern void sm_hfree(IntPtr allocator, ulong handle);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_hlock(IntPtr allocator, ulong handle);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern void sm_hunlock(IntPtr allocator, ulong handle);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_hsize(IntPtr allocator, ulong handle);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern UIntPtr sm_compact(IntPtr allocator, ulong budgetMicroseconds);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_chain_create(IntPtr allocator, IntPtr segmentSize);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern void sm_chain_destroy(IntPtr chain);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_chain_append(IntPtr chain, IntPtr data, IntPtr bytesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_chain_reserve(IntPtr chain, out IntPtr available);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		[return: MarshalAs(UnmanagedType.U1)]
+		internal static extern bool sm_chain_commit(IntPtr chain, IntPtr bytesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_chain_consume(IntPtr chain, IntPtr bytesCount);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern void sm_chain_clear(IntPtr chain);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern IntPtr sm_chain_length(IntPtr chain);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern uint sm_chain_segments(IntPtr chain);
+
+		[DllImport(nativeLibrary, CallingConvention = CallingConvention.Cdecl)]
+		internal static extern uint sm_chain_iovecs(IntPtr chain, [Out] IoVec[] buffers, uint maxBuffersCount);
 	}
 }
\ No newline at end of file
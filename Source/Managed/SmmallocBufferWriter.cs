@@ -0,0 +1,165 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+using System.Buffers;
+
+namespace Smmalloc {
+	public sealed unsafe class SmmallocBufferWriter : IBufferWriter<byte>, IDisposable {
+		private readonly SmmallocInstance smmalloc;
+		private readonly int segmentSize;
+		private IntPtr[] blocks;
+		private int[] lengths;
+		private int[] capacities;
+		private NativeMemoryManager[] managers;
+		private int blocksCount;
+		private long writtenCount;
+
+		public SmmallocBufferWriter(SmmallocInstance smmalloc) : this(smmalloc, 0) { }
+
+		public SmmallocBufferWriter(SmmallocInstance smmalloc, int segmentSize) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (segmentSize < 0)
+				throw new ArgumentOutOfRangeException("segmentSize");
+
+			this.smmalloc = smmalloc;
+			this.segmentSize = segmentSize > 0 ? segmentSize : smmalloc.AllocationLimit;
+			blocks = new IntPtr[8];
+			lengths = new int[8];
+			capacities = new int[8];
+			managers = new NativeMemoryManager[8];
+		}
+
+		public void Dispose() {
+			Reset();
+		}
+
+		public long WrittenCount {
+			get {
+				return writtenCount;
+			}
+		}
+
+		public int SegmentsCount {
+			get {
+				return blocksCount;
+			}
+		}
+
+		public void Advance(int count) {
+			if (count == 0)
+				return;
+
+			if (count < 0 || blocksCount == 0 || lengths[blocksCount - 1] + count > capacities[blocksCount - 1])
+				throw new ArgumentOutOfRangeException("count");
+
+			lengths[blocksCount - 1] += count;
+			writtenCount += count;
+		}
+
+		public Span<byte> GetSpan(int sizeHint = 0) {
+			int index = Reserve(sizeHint);
+
+			return new Span<byte>((byte*)blocks[index] + lengths[index], capacities[index] - lengths[index]);
+		}
+
+		public Memory<byte> GetMemory(int sizeHint = 0) {
+			int index = Reserve(sizeHint);
+
+			if (managers[index] == null)
+				managers[index] = new NativeMemoryManager(blocks[index], capacities[index]);
+
+			return managers[index].Memory.Slice(lengths[index]);
+		}
+
+		public ReadOnlySequence<byte> ToSequence() {
+			NativeSequenceSegment first = null;
+			NativeSequenceSegment last = null;
+
+			for (int i = 0; i < blocksCount; i++) {
+				if (lengths[i] == 0)
+					continue;
+
+				ReadOnlyMemory<byte> memory = new NativeMemoryManager(blocks[i], lengths[i]).Memory;
+
+				if (first == null)
+					first = last = new NativeSequenceSegment(memory, 0);
+				else
+					last = last.Append(memory);
+			}
+
+			if (first == null)
+				return ReadOnlySequence<byte>.Empty;
+
+			return new ReadOnlySequence<byte>(first, 0, last, last.Memory.Length);
+		}
+
+		public void Reset() {
+			if (blocksCount > 0) {
+				// Entries past the used range are null, the batch covers only acquired blocks
+				fixed (IntPtr* batch = blocks) {
+					smmalloc.Free((IntPtr)batch, blocksCount);
+				}
+
+				Array.Clear(blocks, 0, blocksCount);
+				Array.Clear(managers, 0, blocksCount);
+			}
+
+			blocksCount = 0;
+			writtenCount = 0;
+		}
+
+		private int Reserve(int sizeHint) {
+			if (sizeHint < 0)
+				throw new ArgumentOutOfRangeException("sizeHint");
+
+			int index = blocksCount - 1;
+			int required = Math.Max(sizeHint, 1);
+
+			if (index >= 0 && capacities[index] - lengths[index] >= required)
+				return index;
+
+			if (blocksCount == blocks.Length) {
+				Array.Resize(ref blocks, blocksCount * 2);
+				Array.Resize(ref lengths, blocksCount * 2);
+				Array.Resize(ref capacities, blocksCount * 2);
+				Array.Resize(ref managers, blocksCount * 2);
+			}
+
+			int capacity = Math.Max(required, segmentSize);
+			IntPtr memory = smmalloc.MallocUnsafe(capacity);
+
+			if (memory == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			index = blocksCount++;
+			blocks[index] = memory;
+			lengths[index] = 0;
+			capacities[index] = NativeCollection.GetUsableSize(smmalloc, memory, capacity);
+
+			return index;
+		}
+	}
+}
@@ -0,0 +1,169 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+using System.Buffers;
+
+namespace Smmalloc {
+	public class SmmallocChain : IDisposable {
+		private IntPtr nativeChain;
+		private readonly SmmallocInstance smmalloc;
+		private int reservedBytes = -1;
+
+		public SmmallocChain(SmmallocInstance smmalloc) : this(smmalloc, 0) { }
+
+		public SmmallocChain(SmmallocInstance smmalloc, int segmentSize) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (segmentSize < 0)
+				throw new ArgumentOutOfRangeException("segmentSize");
+
+			nativeChain = Native.sm_chain_create(smmalloc.NativeAllocator, (IntPtr)segmentSize);
+
+			if (nativeChain == IntPtr.Zero)
+				throw new InvalidOperationException("Native chain not created");
+
+			this.smmalloc = smmalloc;
+		}
+
+		public void Dispose() {
+			Dispose(true);
+			GC.SuppressFinalize(this);
+		}
+
+		protected virtual void Dispose(bool disposing) {
+			if (nativeChain != IntPtr.Zero) {
+				// The chain lives in the pool, which is already gone if the instance was disposed or finalized first
+				if (smmalloc.NativeAllocator != IntPtr.Zero)
+					Native.sm_chain_destroy(nativeChain);
+
+				nativeChain = IntPtr.Zero;
+			}
+		}
+
+		~SmmallocChain() {
+			Dispose(false);
+		}
+
+		public long Length {
+			get {
+				return (long)Native.sm_chain_length(nativeChain);
+			}
+		}
+
+		public int SegmentsCount {
+			get {
+				return (int)Native.sm_chain_segments(nativeChain);
+			}
+		}
+
+		public SmmallocInstance Allocator {
+			get {
+				return smmalloc;
+			}
+		}
+
+		public unsafe int Append(ReadOnlySpan<byte> data) {
+			reservedBytes = -1;
+
+			fixed (byte* source = &data.GetPinnableReference()) {
+				return (int)Native.sm_chain_append(nativeChain, (IntPtr)source, (IntPtr)data.Length);
+			}
+		}
+
+		public int Append(IntPtr data, int length) {
+			if (data == IntPtr.Zero)
+				throw new ArgumentNullException("data");
+
+			if (length < 0)
+				throw new ArgumentOutOfRangeException("length");
+
+			reservedBytes = -1;
+
+			return (int)Native.sm_chain_append(nativeChain, data, (IntPtr)length);
+		}
+
+		public unsafe Span<byte> GetSpan() {
+			IntPtr available;
+			IntPtr memory = Native.sm_chain_reserve(nativeChain, out available);
+
+			if (memory == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			reservedBytes = (int)available;
+
+			return new Span<byte>((void*)memory, reservedBytes);
+		}
+
+		public void Commit(int bytesCount) {
+			if (reservedBytes < 0)
+				throw new InvalidOperationException("Commit must follow GetSpan");
+
+			if (bytesCount < 0 || bytesCount > reservedBytes)
+				throw new ArgumentOutOfRangeException("bytesCount");
+
+			if (!Native.sm_chain_commit(nativeChain, (IntPtr)bytesCount))
+				throw new InvalidOperationException("Reserved span is no longer valid");
+
+			reservedBytes = -1;
+		}
+
+		public long Consume(long bytesCount) {
+			if (bytesCount < 0)
+				throw new ArgumentOutOfRangeException("bytesCount");
+
+			return (long)Native.sm_chain_consume(nativeChain, (IntPtr)bytesCount);
+		}
+
+		public void Clear() {
+			reservedBytes = -1;
+			Native.sm_chain_clear(nativeChain);
+		}
+
+		public int IoVecs(IoVec[] buffers) {
+			if (buffers == null)
+				throw new ArgumentNullException("buffers");
+
+			return (int)Native.sm_chain_iovecs(nativeChain, buffers, (uint)buffers.Length);
+		}
+
+		public ReadOnlySequence<byte> ToSequence() {
+			IoVec[] buffers = new IoVec[Native.sm_chain_iovecs(nativeChain, null, 0)];
+
+			if (buffers.Length == 0)
+				return ReadOnlySequence<byte>.Empty;
+
+			Native.sm_chain_iovecs(nativeChain, buffers, (uint)buffers.Length);
+
+			NativeSequenceSegment first = new NativeSequenceSegment(new NativeMemoryManager(buffers[0].Base, (int)buffers[0].Length).Memory, 0);
+			NativeSequenceSegment last = first;
+
+			for (int i = 1; i < buffers.Length; i++) {
+				last = last.Append(new NativeMemoryManager(buffers[i].Base, (int)buffers[i].Length).Memory);
+			}
+
+			return new ReadOnlySequence<byte>(first, 0, last, last.Memory.Length);
+		}
+	}
+}
@@ -0,0 +1,295 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+
+namespace Smmalloc {
+	public readonly struct SmmallocHandle : IEquatable<SmmallocHandle> {
+		public readonly ulong Value;
+
+		public SmmallocHandle(ulong value) {
+			Value = value;
+		}
+
+		internal SmmallocHandle(uint index, uint generation) {
+			Value = ((ulong)generation << 32) | index;
+		}
+
+		public uint Index {
+			get {
+				return unchecked((uint)Value);
+			}
+		}
+
+		public uint Generation {
+			get {
+				return (uint)(Value >> 32);
+			}
+		}
+
+		public bool IsNull {
+			get {
+				return Value == 0;
+			}
+		}
+
+		public bool Equals(SmmallocHandle other) {
+			return Value == other.Value;
+		}
+
+		public override bool Equals(object obj) {
+			return obj is SmmallocHandle && Equals((SmmallocHandle)obj);
+		}
+
+		public override int GetHashCode() {
+			return Value.GetHashCode();
+		}
+	}
+
+	public sealed unsafe class SmmallocHandlePool<T> : IDisposable where T : unmanaged {
+		private readonly SmmallocInstance smmalloc;
+		private readonly int chunkShift;
+		private readonly uint chunkMask;
+		private IntPtr* chunks;
+		private uint* generations;
+		private uint* freeIndices;
+		private int chunksCount;
+		private int chunksCapacity;
+		private uint capacity;
+		private uint nextIndex;
+		private uint freeCount;
+		private int count;
+
+		public SmmallocHandlePool(SmmallocInstance smmalloc) : this(smmalloc, 0) { }
+
+		public SmmallocHandlePool(SmmallocInstance smmalloc, int chunkCapacity) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (chunkCapacity < 0 || (chunkCapacity & (chunkCapacity - 1)) != 0)
+				throw new ArgumentOutOfRangeException("chunkCapacity", "Chunk capacity must be a power of two");
+
+			// By default chunks are sized to fit the largest bucket, so elements stay in the pool
+			if (chunkCapacity == 0) {
+				chunkCapacity = 1;
+
+				while (chunkCapacity * 2 * sizeof(T) <= smmalloc.AllocationLimit) {
+					chunkCapacity *= 2;
+				}
+			}
+
+			this.smmalloc = smmalloc;
+
+			while ((1 << chunkShift) < chunkCapacity) {
+				chunkShift++;
+			}
+
+			chunkMask = (uint)chunkCapacity - 1;
+		}
+
+		public void Dispose() {
+			for (int i = 0; i < chunksCount; i++) {
+				smmalloc.Free(chunks[i]);
+			}
+
+			if (chunks != null)
+				smmalloc.Free((IntPtr)chunks);
+
+			if (generations != null)
+				smmalloc.Free((IntPtr)generations);
+
+			if (freeIndices != null)
+				smmalloc.Free((IntPtr)freeIndices);
+
+			chunks = null;
+			generations = null;
+			freeIndices = null;
+			chunksCount = 0;
+			chunksCapacity = 0;
+			capacity = 0;
+			nextIndex = 0;
+			freeCount = 0;
+			count = 0;
+		}
+
+		public int Count {
+			get {
+				return count;
+			}
+		}
+
+		public int Capacity {
+			get {
+				return (int)capacity;
+			}
+		}
+
+		public SmmallocHandle Allocate() {
+			return Allocate(default(T));
+		}
+
+		public SmmallocHandle Allocate(T value) {
+			uint index;
+
+			if (freeCount > 0) {
+				index = freeIndices[--freeCount];
+			} else {
+				if (nextIndex == capacity)
+					AddChunk();
+
+				index = nextIndex++;
+			}
+
+			uint generation = unchecked(generations[index] + 1);
+
+			generations[index] = generation;
+			*GetElement(index) = value;
+			count++;
+
+			return new SmmallocHandle(index, generation);
+		}
+
+		public bool Free(SmmallocHandle handle) {
+			uint index = handle.Index;
+
+			// Even generations belong to free slots, so a default handle never matches
+			if (index >= capacity || (handle.Generation & 1) == 0 || generations[index] != handle.Generation)
+				return false;
+
+			generations[index] = unchecked(handle.Generation + 1);
+			freeIndices[freeCount++] = index;
+			count--;
+
+			return true;
+		}
+
+		#if SMMALLOC_INLINING
+			[System.Runtime.CompilerServices.MethodImpl(256)]
+		#endif
+		public bool IsValid(SmmallocHandle handle) {
+			uint index = handle.Index;
+
+			return index < capacity && (handle.Generation & 1) != 0 && generations[index] == handle.Generation;
+		}
+
+		#if SMMALLOC_INLINING
+			[System.Runtime.CompilerServices.MethodImpl(256)]
+		#endif
+		public ref T Resolve(SmmallocHandle handle) {
+			uint index = handle.Index;
+
+			if (index >= capacity || (handle.Generation & 1) == 0 || generations[index] != handle.Generation)
+				throw new ArgumentException("Handle is not valid", "handle");
+
+			return ref *GetElement(index);
+		}
+
+		public bool TryGetValue(SmmallocHandle handle, out T value) {
+			if (!IsValid(handle)) {
+				value = default(T);
+
+				return false;
+			}
+
+			value = *GetElement(handle.Index);
+
+			return true;
+		}
+
+		public Enumerator GetEnumerator() {
+			return new Enumerator(this);
+		}
+
+		private T* GetElement(uint index) {
+			return (T*)chunks[index >> chunkShift] + (index & chunkMask);
+		}
+
+		private void AddChunk() {
+			uint chunkCapacity = chunkMask + 1;
+			uint newCapacity = checked(capacity + chunkCapacity);
+
+			if (newCapacity > int.MaxValue)
+				throw new OutOfMemoryException();
+
+			if (chunksCount == chunksCapacity) {
+				int newChunksCapacity = Math.Max(chunksCapacity * 2, 4);
+
+				chunks = (IntPtr*)Reallocate((IntPtr)chunks, newChunksCapacity * sizeof(IntPtr));
+				chunksCapacity = newChunksCapacity;
+			}
+
+			// Index arrays grow first, if one of them throws the pool keeps its capacity and nothing leaks
+			generations = (uint*)Reallocate((IntPtr)generations, (int)newCapacity * sizeof(uint));
+			freeIndices = (uint*)Reallocate((IntPtr)freeIndices, (int)newCapacity * sizeof(uint));
+
+			IntPtr chunk = smmalloc.MallocUnsafe(checked((int)chunkCapacity * sizeof(T)));
+
+			if (chunk == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			new Span<uint>(generations + capacity, (int)chunkCapacity).Clear();
+			chunks[chunksCount++] = chunk;
+			capacity = newCapacity;
+		}
+
+		private IntPtr Reallocate(IntPtr memory, int bytesCount) {
+			IntPtr result = smmalloc.ReallocUnsafe(memory, bytesCount);
+
+			if (result == IntPtr.Zero)
+				throw new OutOfMemoryException();
+
+			return result;
+		}
+
+		public ref struct Enumerator {
+			private readonly SmmallocHandlePool<T> pool;
+			private int index;
+
+			internal Enumerator(SmmallocHandlePool<T> pool) {
+				this.pool = pool;
+				index = -1;
+			}
+
+			public bool MoveNext() {
+				while (++index < (int)pool.nextIndex) {
+					if ((pool.generations[index] & 1) != 0)
+						return true;
+				}
+
+				return false;
+			}
+
+			public ref T Current {
+				get {
+					return ref *pool.GetElement((uint)index);
+				}
+			}
+
+			public SmmallocHandle CurrentHandle {
+				get {
+					return new SmmallocHandle((uint)index, pool.generations[index]);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,97 @@
+/*
+ *  Managed C# wrapper for Smmalloc, blazing fast memory allocator designed for video games 
+ *  Copyright (c) 2018 Stanislav Denisov
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Smmalloc {
+	public class SmmallocTaskScheduler : TaskScheduler, IDisposable {
+		private readonly BlockingCollection<Task> tasks;
+		private readonly Thread[] threads;
+		[ThreadStatic]
+		private static SmmallocTaskScheduler currentScheduler;
+
+		public SmmallocTaskScheduler(SmmallocInstance smmalloc, int threadsCount) {
+			if (smmalloc == null)
+				throw new ArgumentNullException("smmalloc");
+
+			if (threadsCount <= 0)
+				throw new ArgumentOutOfRangeException("threadsCount");
+
+			tasks = new BlockingCollection<Task>();
+			threads = new Thread[threadsCount];
+
+			for (int i = 0; i < threads.Length; i++) {
+				threads[i] = smmalloc.CreateThread(Execute);
+				threads[i].IsBackground = true;
+				threads[i].Name = "Smmalloc Worker " + i;
+				threads[i].Start();
+			}
+		}
+
+		public override int MaximumConcurrencyLevel {
+			get {
+				return threads.Length;
+			}
+		}
+
+		public void Dispose() {
+			if (tasks.IsAddingCompleted)
+				return;
+
+			tasks.CompleteAdding();
+
+			foreach (Thread thread in threads) {
+				thread.Join();
+			}
+
+			tasks.Dispose();
+		}
+
+		protected override void QueueTask(Task task) {
+			tasks.Add(task);
+		}
+
+		protected override bool TryExecuteTaskInline(Task task, bool taskWasPreviouslyQueued) {
+			if (currentScheduler != this)
+				return false;
+
+			return TryExecuteTask(task);
+		}
+
+		protected override IEnumerable<Task> GetScheduledTasks() {
+			return tasks.ToArray();
+		}
+
+		private void Execute() {
+			currentScheduler = this;
+
+			foreach (Task task in tasks.GetConsumingEnumerable()) {
+				TryExecuteTask(task);
+			}
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#include <smmalloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Hit rate of the first level thread cache per bucket under random bursts of allocations and releases, with the extension slots
+// of the smallest classes against the same total depth spread evenly
+
+static const size_t CacheSize = 256;
+static const size_t MaxBurstCount = 48;
+static const size_t OperationsCount = 4000000;
+
+static uint32_t Random(uint32_t& state) {
+	state = state * 1664525u + 1013904223u;
+
+	return state >> 16;
+}
+
+// Baseline with the inline depth for every class and no slots moved between classes
+struct FixedDepthConfig : sm::DefaultConfig {
+	static const uint32_t CacheExtensionSize = 0;
+};
+
+template<typename Config>
+static bool Measure(const char* name) {
+	sm::BasicAllocator<Config> allocator(sm::GenericAllocator::Invalid());
+
+	if (!allocator.Init(64, 4 * 1024 * 1024) || !allocator.CreateThreadCache(sm::CACHE_HOT, CacheSize)) {
+		printf("Allocator creation failed\n");
+
+		return false;
+	}
+
+	const size_t buckets[] = { 0, 1, 2, 3, 4, 7, 15, 31, 63 };
+	size_t totalDepth = 0;
+
+	for (size_t bucketIndex = 0; bucketIndex < 64; bucketIndex++) {
+		totalDepth += sm::BasicAllocator<Config>::GetTlsBucket(bucketIndex)->maxElementsL0;
+	}
+
+	printf("%s, L0 depth %zu in total\n", name, totalDepth);
+
+	for (size_t bucketIndex : buckets) {
+		size_t bytesCount = (bucketIndex + 1) * 16;
+		typename sm::BasicAllocator<Config>::TlsBucket* bucket = sm::BasicAllocator<Config>::GetTlsBucket(bucketIndex);
+		void* blocks[MaxBurstCount];
+		size_t blocksCount = 0;
+		size_t allocationsCount = 0;
+		size_t hitsCount = 0;
+		uint32_t state = 1;
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < OperationsCount;) {
+			size_t burstCount = 1 + Random(state) % MaxBurstCount;
+			size_t j;
+
+			for (j = blocksCount; j < burstCount; j++, i++) {
+				hitsCount += (bucket->numElementsL0 > 0) ? 1 : 0;
+				blocks[j] = allocator.Alloc(bytesCount, 16);
+				allocationsCount++;
+			}
+
+			blocksCount = std::max(blocksCount, burstCount);
+			burstCount = Random(state) % (blocksCount + 1);
+
+			for (j = blocksCount; j > burstCount; j--, i++) {
+				allocator.Free(blocks[j - 1]);
+			}
+
+			blocksCount = burstCount;
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		for (size_t j = 0; j < blocksCount; j++) {
+			allocator.Free(blocks[j]);
+		}
+
+		double time = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (double)OperationsCount;
+
+		printf("bucket %2zu (%4zu bytes): L0 depth %3u, L0 hit rate %5.1f%%, %5.1f ns per operation\n", bucketIndex, bytesCount, (unsigned)bucket->maxElementsL0, 100.0 * (double)hitsCount / (double)allocationsCount, time);
+	}
+
+	allocator.DestroyThreadCache();
+
+	return true;
+}
+
+int main() {
+	if (!Measure<FixedDepthConfig>("fixed depth") || !Measure<sm::DefaultConfig>("shared extension"))
+		return 1;
+
+	return 0;
+}
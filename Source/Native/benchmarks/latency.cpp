@@ -0,0 +1,117 @@
+#include <smmalloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Tail latency of an allocate and release pair on a real-time thread while other threads hammer the same bucket, the reserved
+// thread must serve every operation from its quota, wall-clock tails also include preemption which the allocator can't bound
+
+static const size_t ElementSize = 64;
+static const size_t QuotaSize = 64;
+static const size_t IterationsCount = 1000000;
+
+static void Contend(sm_allocator allocator, std::atomic<bool>* running) {
+	void* blocks[32];
+
+	while (running->load(std::memory_order_relaxed)) {
+		for (size_t i = 0; i < 32; i++) {
+			blocks[i] = sm_malloc(allocator, ElementSize, 16);
+		}
+
+		for (size_t i = 0; i < 32; i++) {
+			sm_free(allocator, blocks[i]);
+		}
+	}
+}
+
+static size_t Measure(sm_allocator allocator, const char* name, sm::CacheWarmupOptions warmupOptions) {
+	std::vector<uint64_t> samples(IterationsCount);
+	void* blocks[QuotaSize / 2];
+	size_t bucketIndex = (ElementSize - 1) >> 4;
+	size_t poolOperationsCount = 0;
+
+	if (warmupOptions != sm::CACHE_COLD)
+		sm_allocator_thread_cache_create_ex(allocator, warmupOptions, QuotaSize, uint64_t(1) << ((ElementSize - 1) >> 4));
+
+	for (size_t i = 0; i < IterationsCount; i++) {
+		size_t count = (i % (QuotaSize / 2)) + 1;
+		uint32_t cachedCount = sm::Allocator::GetTlsBucket(bucketIndex)->GetElementsCount();
+		auto start = std::chrono::steady_clock::now();
+
+		for (size_t j = 0; j < count; j++) {
+			blocks[j] = sm_malloc(allocator, ElementSize, 16);
+		}
+
+		for (size_t j = 0; j < count; j++) {
+			sm_free(allocator, blocks[j]);
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		samples[i] = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / count;
+
+		// The cache serves every allocation only if it holds enough elements, and keeps every release only if all of them come back
+		if (cachedCount < count || sm::Allocator::GetTlsBucket(bucketIndex)->GetElementsCount() != cachedCount)
+			poolOperationsCount++;
+	}
+
+	if (warmupOptions != sm::CACHE_COLD)
+		sm_allocator_thread_cache_destroy(allocator);
+
+	std::sort(samples.begin(), samples.end());
+
+	const double percentiles[] = { 0.5, 0.99, 0.999, 0.99999 };
+
+	printf("%-10s", name);
+
+	for (double percentile : percentiles) {
+		printf(" p%-8g %6llu ns", percentile * 100.0, (unsigned long long)samples[(size_t)(percentile * (IterationsCount - 1))]);
+	}
+
+	printf(" max %llu ns, %zu iterations reached the pool\n", (unsigned long long)samples.back(), poolOperationsCount);
+
+	return poolOperationsCount;
+}
+
+int main() {
+	sm_allocator allocator = sm_allocator_create_ex(8, 4 * 1024 * 1024, sm::ALLOCATOR_PREFAULT | sm::ALLOCATOR_NO_FALLBACK);
+
+	if (allocator == nullptr) {
+		printf("Allocator creation failed\n");
+
+		return 1;
+	}
+
+	std::atomic<bool> running(true);
+	std::vector<std::thread> threads;
+	unsigned int threadsCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	for (unsigned int i = 0; i < std::min(threadsCount, 7u); i++) {
+		threads.emplace_back(Contend, allocator, &running);
+	}
+
+	Measure(allocator, "shared", sm::CACHE_COLD);
+
+	size_t reservedPoolOperationsCount = Measure(allocator, "reserved", sm::CACHE_RESERVED);
+
+	running.store(false, std::memory_order_relaxed);
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	sm_allocator_destroy(allocator);
+
+	// Operations of a reserved thread are bounded only while they never leave its quota
+	if (reservedPoolOperationsCount > 0) {
+		printf("Reserved thread reached the pool\n");
+
+		return 1;
+	}
+
+	return 0;
+}
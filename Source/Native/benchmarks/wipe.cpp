@@ -0,0 +1,66 @@
+#include <smmalloc.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Cost of zeroing memory blocks on release, regular stores for small elements and non-temporal ones for large elements
+
+static const size_t BlocksCount = 256;
+static const size_t RoundsCount = 20000;
+
+typedef void (*FreeFunction)(sm_allocator allocator, void* p);
+
+static double Measure(sm_allocator allocator, size_t bytesCount, FreeFunction freeFunction) {
+	void* blocks[BlocksCount];
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < RoundsCount; i++) {
+		for (size_t j = 0; j < BlocksCount; j++) {
+			blocks[j] = sm_malloc(allocator, bytesCount, 16);
+			std::memset(blocks[j], (int)j, bytesCount);
+		}
+
+		for (size_t j = 0; j < BlocksCount; j++) {
+			freeFunction(allocator, blocks[j]);
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (double)(RoundsCount * BlocksCount);
+}
+
+static void Free(sm_allocator allocator, void* p) {
+	sm_free(allocator, p);
+}
+
+static void FreeWipe(sm_allocator allocator, void* p) {
+	sm_free_wipe(allocator, p);
+}
+
+int main() {
+	sm_allocator allocator = sm_allocator_create(64, 4 * 1024 * 1024);
+
+	if (allocator == nullptr) {
+		printf("Allocator creation failed\n");
+
+		return 1;
+	}
+
+	sm_allocator_thread_cache_create(allocator, sm::CACHE_HOT, BlocksCount);
+
+	const size_t sizes[] = { 64, 1024 };
+
+	for (size_t bytesCount : sizes) {
+		double freeTime = Measure(allocator, bytesCount, Free);
+		double wipeTime = Measure(allocator, bytesCount, FreeWipe);
+
+		printf("%4zu bytes: sm_free %6.1f ns, sm_free_wipe %6.1f ns per allocation\n", bytesCount, freeTime, wipeTime);
+	}
+
+	sm_allocator_thread_cache_destroy(allocator);
+	sm_allocator_destroy(allocator);
+
+	return 0;
+}
@@ -21,211 +21,480 @@
 *  SOFTWARE.
 */
 
+#include <chrono>
 #include <malloc.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SMMALLOC_EXPORTS
+
 #include "smmalloc.h"
 
-thread_local sm::internal::TlsPoolBucket tlsCacheBuckets[SMM_MAX_BUCKET_COUNT];
+#if defined(__linux__)
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
 
-namespace sm {
-	struct CacheWarmupLink {
-		CacheWarmupLink* pNext;
-	};
+	#define SMMALLOC_MMAP_SUPPORT
 
-	sm::internal::TlsPoolBucket* __restrict GetTlsBucket(size_t index) {
-		return &tlsCacheBuckets[index];
-	}
+	#if defined(__NR_memfd_create)
+		#define SMMALLOC_MEMFD_SUPPORT
+
+		#define SMM_MFD_CLOEXEC (1U)
+	#endif
+
+	#if defined(__NR_io_uring_register)
+		#define SMMALLOC_IO_URING_SUPPORT
+
+		#define SMM_IORING_REGISTER_BUFFERS (0)
+		#define SMM_IORING_UNREGISTER_BUFFERS (1)
+		#define SMM_IORING_MAX_BUFFER_SIZE (size_t(1) << 30)
+	#endif
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <immintrin.h>
+
+	#define SMMALLOC_SSE2_SUPPORT
+#endif
+
+#if defined(__AVX2__)
+	#define SMMALLOC_AVX2_COPY
+	#define SMM_COPY_VECTOR_SIZE (32)
+	#define SMM_COPY_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+	#define SMM_COPY_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
 
+	typedef __m256i CopyVector;
+#elif defined(SMMALLOC_SSE2_SUPPORT)
+	#define SMM_COPY_VECTOR_SIZE (16)
+	#define SMM_COPY_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+	#define SMM_COPY_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+
+	typedef __m128i CopyVector;
+#endif
+
+#define SMM_STREAM_WIPE_MIN_SIZE (256)
+
+namespace sm {
 	namespace internal {
-		void TlsPoolBucket::Init(uint32_t* pCacheStack, uint32_t maxElementsNum, CacheWarmupOptions warmupOptions, Allocator* alloc, size_t bucketIndex) {
-			SM_ASSERT(numElementsL0 == 0);
-			SM_ASSERT(numElementsL1 == 0);
-			SM_ASSERT(pBucket == nullptr);
-			SM_ASSERT(pBucketData == nullptr);
-			SM_ASSERT(pStorageL1 == nullptr);
-			SM_ASSERT(maxElementsCount == 0);
+		// The size is a compile-time constant, so loops are fully unrolled into vector loads and stores
+		template<size_t bytesCount>
+		static void CopyElement(void* __restrict _pDst, const void* __restrict _pSrc) {
+			#ifdef SMM_COPY_VECTOR_SIZE
+				uint8_t* __restrict pDst = (uint8_t*)_pDst;
+				const uint8_t* __restrict pSrc = (const uint8_t*)_pSrc;
+				size_t i = 0;
+
+				for (; i + 4 * SMM_COPY_VECTOR_SIZE <= bytesCount; i += 4 * SMM_COPY_VECTOR_SIZE) {
+					CopyVector v0 = SMM_COPY_LOAD(pSrc + i);
+					CopyVector v1 = SMM_COPY_LOAD(pSrc + i + SMM_COPY_VECTOR_SIZE);
+					CopyVector v2 = SMM_COPY_LOAD(pSrc + i + 2 * SMM_COPY_VECTOR_SIZE);
+					CopyVector v3 = SMM_COPY_LOAD(pSrc + i + 3 * SMM_COPY_VECTOR_SIZE);
+
+					SMM_COPY_STORE(pDst + i, v0);
+					SMM_COPY_STORE(pDst + i + SMM_COPY_VECTOR_SIZE, v1);
+					SMM_COPY_STORE(pDst + i + 2 * SMM_COPY_VECTOR_SIZE, v2);
+					SMM_COPY_STORE(pDst + i + 3 * SMM_COPY_VECTOR_SIZE, v3);
+				}
 
-			Allocator::PoolBucket* poolBucket = alloc->GetBucketByIndex(bucketIndex);
+				for (; i + SMM_COPY_VECTOR_SIZE <= bytesCount; i += SMM_COPY_VECTOR_SIZE) {
+					SMM_COPY_STORE(pDst + i, SMM_COPY_LOAD(pSrc + i));
+				}
 
-			SM_ASSERT(maxElementsNum >= SMM_MAX_CACHE_ITEMS_COUNT + 2);
+				#ifdef SMMALLOC_AVX2_COPY
+					if (i < bytesCount)
+						_mm_storeu_si128((__m128i*)(pDst + i), _mm_loadu_si128((const __m128i*)(pSrc + i)));
+				#endif
+			#else
+				std::memcpy(_pDst, _pSrc, bytesCount);
+			#endif
+		}
 
-			pStorageL1 = pCacheStack;
-			numElementsL1 = 0;
-			numElementsL0 = 0;
-			maxElementsCount = (maxElementsNum - SMM_MAX_CACHE_ITEMS_COUNT);
-			pBucket = poolBucket;
+		// Large memory blocks are zeroed with non-temporal stores, which bypass the cache since the memory won't be read again soon
+		void WipeMemory(void* p, size_t bytesCount) {
+			#ifdef SMMALLOC_SSE2_SUPPORT
+				if (bytesCount >= SMM_STREAM_WIPE_MIN_SIZE) {
+					uint8_t* pData = (uint8_t*)p;
+					uint8_t* pEnd = pData + bytesCount;
+					uint8_t* pAligned = (uint8_t*)Align((size_t)pData, 16);
+					__m128i zero = _mm_setzero_si128();
 
-			SM_ASSERT(pBucket);
+					std::memset(pData, 0, pAligned - pData);
 
-			pBucketData = pBucket->pData;
+					for (; pAligned + 64 <= pEnd; pAligned += 64) {
+						_mm_stream_si128((__m128i*)pAligned, zero);
+						_mm_stream_si128((__m128i*)(pAligned + 16), zero);
+						_mm_stream_si128((__m128i*)(pAligned + 32), zero);
+						_mm_stream_si128((__m128i*)(pAligned + 48), zero);
+					}
 
-			if (warmupOptions == CACHE_COLD)
-				return;
+					for (; pAligned + 16 <= pEnd; pAligned += 16) {
+						_mm_stream_si128((__m128i*)pAligned, zero);
+					}
 
-			uint32_t elementSize = alloc->GetBucketElementSize(bucketIndex);
-			uint32_t num = (warmupOptions == CACHE_WARM) ? (maxElementsCount / 2) : (maxElementsCount);
+					// Streaming stores are weakly ordered, the memory block may be reused by another thread right after
+					_mm_sfence();
 
-			CacheWarmupLink* pRoot = nullptr;
+					std::memset(pAligned, 0, pEnd - pAligned);
 
-			for (uint32_t j = 0; j < num; j++) {
-				void* p = alloc->Allocate<false>(elementSize, 16);
+					return;
+				}
+			#endif
 
-				if (p == nullptr)
-					break;
+			std::memset(p, 0, bytesCount);
+		}
 
-				if (alloc->GetBucketIndex(p) != (int32_t)bucketIndex) {
-					alloc->Free(p);
+		const CopyKernel copyKernels[SMM_MAX_BUCKET_COUNT] = {
+			&CopyElement<16>, &CopyElement<32>, &CopyElement<48>, &CopyElement<64>, &CopyElement<80>, &CopyElement<96>, &CopyElement<112>, &CopyElement<128>,
+			&CopyElement<144>, &CopyElement<160>, &CopyElement<176>, &CopyElement<192>, &CopyElement<208>, &CopyElement<224>, &CopyElement<240>, &CopyElement<256>,
+			&CopyElement<272>, &CopyElement<288>, &CopyElement<304>, &CopyElement<320>, &CopyElement<336>, &CopyElement<352>, &CopyElement<368>, &CopyElement<384>,
+			&CopyElement<400>, &CopyElement<416>, &CopyElement<432>, &CopyElement<448>, &CopyElement<464>, &CopyElement<480>, &CopyElement<496>, &CopyElement<512>,
+			&CopyElement<528>, &CopyElement<544>, &CopyElement<560>, &CopyElement<576>, &CopyElement<592>, &CopyElement<608>, &CopyElement<624>, &CopyElement<640>,
+			&CopyElement<656>, &CopyElement<672>, &CopyElement<688>, &CopyElement<704>, &CopyElement<720>, &CopyElement<736>, &CopyElement<752>, &CopyElement<768>,
+			&CopyElement<784>, &CopyElement<800>, &CopyElement<816>, &CopyElement<832>, &CopyElement<848>, &CopyElement<864>, &CopyElement<880>, &CopyElement<896>,
+			&CopyElement<912>, &CopyElement<928>, &CopyElement<944>, &CopyElement<960>, &CopyElement<976>, &CopyElement<992>, &CopyElement<1008>, &CopyElement<1024>
+		};
+
+		uint8_t* AllocateArena(GenericAllocator::TInstance instance, size_t bytesCount, size_t alignment, uint32_t options, size_t* pMappedBytesCount, int* pFd) {
+			#ifdef SMMALLOC_MMAP_SUPPORT
+				// Parallel initialization faults pages in from the worker threads, population on this thread would defeat first-touch placement
+				bool populate = (options & ALLOCATOR_PREFAULT) != 0 && (options & ALLOCATOR_PARALLEL_INIT) == 0;
+
+				if ((options & ALLOCATOR_MEMFD) == 0 && !populate)
+					return (uint8_t*)GenericAllocator::Alloc(instance, bytesCount, alignment);
+
+				int fd = -1;
+				int flags = populate ? MAP_POPULATE : 0;
+
+				if (options & ALLOCATOR_MEMFD) {
+					#ifdef SMMALLOC_MEMFD_SUPPORT
+						fd = (int)syscall(__NR_memfd_create, "smmalloc", SMM_MFD_CLOEXEC);
+					#endif
+
+					if (fd < 0)
+						return nullptr;
+
+					if (ftruncate(fd, (off_t)bytesCount) != 0) {
+						close(fd);
+
+						return nullptr;
+					}
+
+					flags |= MAP_SHARED;
+				} else {
+					flags |= MAP_PRIVATE | MAP_ANONYMOUS;
+				}
 
-					break;
+				void* p = mmap(nullptr, bytesCount, PROT_READ | PROT_WRITE, flags, fd, 0);
+
+				if (p == MAP_FAILED) {
+					if (fd >= 0)
+						close(fd);
+
+					return nullptr;
 				}
 
-				CacheWarmupLink* pItem = (CacheWarmupLink*)p;
-				pItem->pNext = pRoot;
-				pRoot = pItem;
-			}
+				SM_ASSERT(IsAligned((size_t)p, alignment) && "Alignment failed");
 
-			CacheWarmupLink* pCurrent = pRoot;
+				*pMappedBytesCount = bytesCount;
+				*pFd = fd;
 
-			while (pCurrent) {
-				CacheWarmupLink* pNext = pCurrent->pNext;
+				return (uint8_t*)p;
+			#else
+				SMMALLOC_UNUSED(pMappedBytesCount);
+				SMMALLOC_UNUSED(pFd);
 
-				bool r = alloc->ReleaseToCache<false>(this, pCurrent);
+				if (options & ALLOCATOR_MEMFD)
+					return nullptr;
 
-				SMMALLOC_USED_IN_ASSERT(r);
-				SM_ASSERT(r);
+				return (uint8_t*)GenericAllocator::Alloc(instance, bytesCount, alignment);
+			#endif
+		}
 
-				pCurrent = pNext;
-			}
+		void FreeArena(GenericAllocator::TInstance instance, uint8_t* p, size_t mappedBytesCount, size_t lockedBytesCount, int fd) {
+			#ifdef SMMALLOC_MMAP_SUPPORT
+				if (lockedBytesCount > 0)
+					munlock(p, lockedBytesCount);
+
+				if (mappedBytesCount > 0) {
+					munmap(p, mappedBytesCount);
 
-			SM_ASSERT(GetElementsCount() == num);
+					if (fd >= 0)
+						close(fd);
+
+					return;
+				}
+			#else
+				SMMALLOC_UNUSED(mappedBytesCount);
+				SMMALLOC_UNUSED(lockedBytesCount);
+				SMMALLOC_UNUSED(fd);
+			#endif
+
+			GenericAllocator::Free(instance, p);
 		}
 
-		uint32_t* TlsPoolBucket::Destroy() {
-			for (uint32_t i = 0; i < numElementsL0; i++) {
-				pStorageL1[numElementsL1] = storageL0[i];
-				numElementsL1++;
-			}
+		bool LockArena(uint8_t* p, size_t bytesCount) {
+			#ifdef SMMALLOC_MMAP_SUPPORT
+				return mlock(p, bytesCount) == 0;
+			#else
+				SMMALLOC_UNUSED(p);
+				SMMALLOC_UNUSED(bytesCount);
 
-			if (numElementsL1 > 0)
-				ReturnL1CacheToMaster(numElementsL1);
+				return false;
+			#endif
+		}
 
-			uint32_t* r = pStorageL1;
+		bool RegisterIoRing(int ringFd, const IoVec* pBuffers, uint32_t buffersCount) {
+			#ifdef SMMALLOC_IO_URING_SUPPORT
+				for (uint32_t i = 0; i < buffersCount; i++) {
+					if (pBuffers[i].length > SMM_IORING_MAX_BUFFER_SIZE)
+						return false;
+				}
 
-			pStorageL1 = nullptr;
-			numElementsL0 = 0;
-			numElementsL1 = 0;
-			maxElementsCount = 0;
-			pBucket = nullptr;
-			pBucketData = nullptr;
+				return syscall(__NR_io_uring_register, ringFd, SMM_IORING_REGISTER_BUFFERS, pBuffers, buffersCount) >= 0;
+			#else
+				SMMALLOC_UNUSED(ringFd);
+				SMMALLOC_UNUSED(pBuffers);
+				SMMALLOC_UNUSED(buffersCount);
 
-			return r;
+				return false;
+			#endif
 		}
-	}
 
-	void Allocator::CreateThreadCache(CacheWarmupOptions warmupOptions, size_t cacheSize) {
-		for (size_t i = 0; i < bucketsCount; i++) {
-			uint32_t elementsNum = (uint32_t)cacheSize + SMM_MAX_CACHE_ITEMS_COUNT;
-			uint32_t* localStack = (uint32_t*)GenericAllocator::Alloc(gAllocator, elementsNum * sizeof(uint32_t), 64);
-			GetTlsBucket(i)->Init(localStack, elementsNum, warmupOptions, this, i);
+		bool UnregisterIoRing(int ringFd) {
+			#ifdef SMMALLOC_IO_URING_SUPPORT
+				return syscall(__NR_io_uring_register, ringFd, SMM_IORING_UNREGISTER_BUFFERS, nullptr, 0) == 0;
+			#else
+				SMMALLOC_UNUSED(ringFd);
 
-			i++;
+				return false;
+			#endif
 		}
 	}
 
-	void Allocator::DestroyThreadCache() {
-		for (size_t i = 0; i < SMM_MAX_BUCKET_COUNT; i++) {
-			uint32_t* p = GetTlsBucket(i)->Destroy();
-			GenericAllocator::Free(gAllocator, p);
+	Chain::Chain(Allocator* allocator, size_t segmentSize) : pAllocator(allocator), pHead(nullptr), pTail(nullptr), pReserved(nullptr), length(0), segmentsCount(0), segmentCapacity(0) {
+		size_t maxSegmentSize = allocator->GetBucketElementSize(allocator->GetBucketsCount() - 1);
+
+		// Segments larger than the largest bucket would be served by the generic allocator
+		if (segmentSize == 0 || segmentSize > maxSegmentSize)
+			segmentSize = maxSegmentSize;
+
+		segmentSize = Align(std::max(segmentSize, sizeof(Segment) * 2), 16);
+		segmentCapacity = (uint32_t)(segmentSize - sizeof(Segment));
+	}
+
+	Chain::~Chain() {
+		Clear();
+	}
+
+	Chain::Segment* Chain::AppendSegment() {
+		Segment* segment = (Segment*)pAllocator->Alloc(sizeof(Segment) + segmentCapacity, 16);
+
+		if (segment == nullptr)
+			return nullptr;
+
+		segment->pNext = nullptr;
+		segment->offset = 0;
+		segment->length = 0;
+
+		if (pTail)
+			pTail->pNext = segment;
+		else
+			pHead = segment;
+
+		pTail = segment;
+		segmentsCount++;
+
+		return segment;
+	}
+
+	void Chain::ReleaseHead() {
+		SM_ASSERT(pHead != nullptr);
+
+		Segment* segment = pHead;
+
+		pHead = segment->pNext;
+
+		if (pHead == nullptr)
+			pTail = nullptr;
+
+		if (segment == pReserved)
+			pReserved = nullptr;
+
+		length -= segment->length;
+		segmentsCount--;
+		pAllocator->Free(segment);
+	}
+
+	void* Chain::Reserve(size_t* pAvailable) {
+		Segment* segment = pTail;
+
+		if (segment == nullptr || segment->offset + segment->length == segmentCapacity)
+			segment = AppendSegment();
+
+		if (segment == nullptr) {
+			*pAvailable = 0;
+
+			return nullptr;
 		}
+
+		uint32_t used = segment->offset + segment->length;
+
+		pReserved = segment;
+
+		*pAvailable = segmentCapacity - used;
+
+		return segment->GetData() + used;
 	}
 
-	void Allocator::PoolBucket::Create(size_t elementSize) {
-		SM_ASSERT(elementSize >= 16 && "Invalid element size");
+	bool Chain::Commit(size_t bytesCount) {
+		// Only the space handed out by the last reservation can be committed
+		if (pReserved == nullptr || pReserved != pTail)
+			return false;
 
-		globalTag.store(0, std::memory_order_relaxed);
+		if (bytesCount > segmentCapacity - (pTail->offset + pTail->length))
+			return false;
 
-		uint8_t* node = pData;
+		pTail->length += (uint32_t)bytesCount;
+		length += bytesCount;
+		pReserved = nullptr;
 
-		TaggedIndex headVal;
-		headVal.p.tag = globalTag.load(std::memory_order_relaxed);
-		headVal.p.offset = (uint32_t)(node - pData);
-		head.store(headVal.u);
+		return true;
+	}
 
-		while (true) {
-			uint8_t* next = node + elementSize;
+	size_t Chain::Append(const void* pData, size_t bytesCount) {
+		const uint8_t* pSource = (const uint8_t*)pData;
+		size_t appended = 0;
 
-			if ((next + elementSize) <= pBufferEnd) {
-				TaggedIndex nextVal;
-				nextVal.p.tag = globalTag.load(std::memory_order_relaxed);;
-				nextVal.p.offset = (uint32_t)(next - pData);
-				*((TaggedIndex*)(node)) = nextVal;
-			} else {
-				((TaggedIndex*)(node))->u = TaggedIndex::Invalid;
+		while (appended < bytesCount) {
+			size_t available = 0;
+			uint8_t* pDestination = (uint8_t*)Reserve(&available);
 
+			if (pDestination == nullptr)
 				break;
-			}
 
-			node = next;
-			globalTag.fetch_add(1, std::memory_order_relaxed);
+			size_t count = std::min(available, bytesCount - appended);
+
+			std::memcpy(pDestination, pSource + appended, count);
+			Commit(count);
+			appended += count;
 		}
+
+		return appended;
 	}
 
-	Allocator::Allocator(GenericAllocator::TInstance allocator) : bucketsCount(0), bucketSizeInBytes(0), pBufferEnd(nullptr), pBuffer(nullptr, GenericAllocator::Deleter(allocator)), gAllocator(allocator) {
-		#ifdef SMMALLOC_STATS_SUPPORT
-			globalMissCount.store(0);
-		#endif
+	size_t Chain::Consume(size_t bytesCount) {
+		size_t consumed = 0;
+
+		while (consumed < bytesCount && pHead != nullptr) {
+			uint32_t count = (uint32_t)std::min((size_t)pHead->length, bytesCount - consumed);
+
+			pHead->offset += count;
+			pHead->length -= count;
+			length -= count;
+			consumed += count;
+
+			if (pHead->length == 0) {
+				// A reserved segment stays until the reservation is committed
+				if (pHead == pReserved)
+					break;
+
+				ReleaseHead();
+			}
+		}
+
+		return consumed;
 	}
 
-	inline int GetNextPow2(uint32_t n) {
-		n -= 1;
-		n |= n >> 16;
-		n |= n >> 8;
-		n |= n >> 4;
-		n |= n >> 2;
-		n |= n >> 1;
+	void Chain::Clear() {
+		while (pHead != nullptr) {
+			ReleaseHead();
+		}
 
-		return n + 1;
+		SM_ASSERT(length == 0);
 	}
 
-	void Allocator::Init(uint32_t _bucketsCount, size_t _bucketSizeInBytes) {
-		if (bucketsCount > 0)
-			return;
+	uint32_t Chain::GetIoVecs(IoVec* pBuffers, uint32_t maxBuffersCount) const {
+		uint32_t count = 0;
 
-		SM_ASSERT(_bucketsCount > 0 && _bucketsCount <= 64);
+		for (Segment* segment = pHead; segment != nullptr; segment = segment->pNext) {
+			if (segment->length == 0)
+				continue;
 
-		if (_bucketsCount == 0)
-			return;
+			if (pBuffers != nullptr) {
+				if (count >= maxBuffersCount)
+					break;
 
-		bucketsCount = _bucketsCount;
+				pBuffers[count].base = segment->GetData() + segment->offset;
+				pBuffers[count].length = segment->length;
+			}
 
-		size_t alignmentMax = GetNextPow2((uint32_t)(16 * bucketsCount));
+			count++;
+		}
 
-		bucketSizeInBytes = Align(_bucketSizeInBytes, alignmentMax);
+		return count;
+	}
 
-		size_t i = 0;
+	namespace internal {
+		HandlePage* CreateHandlePage(GenericAllocator::TInstance instance, uint32_t elementSize) {
+			size_t headerSize = sizeof(HandlePage);
+			uint32_t capacity = (uint32_t)((SMM_HANDLE_PAGE_SIZE - headerSize - 16) / (elementSize + sizeof(uint32_t)));
+			uint8_t* p = (uint8_t*)GenericAllocator::Alloc(instance, SMM_HANDLE_PAGE_SIZE, SMM_CACHE_LINE_SIZE);
+
+			if (p == nullptr)
+				return nullptr;
+
+			HandlePage* page = (HandlePage*)p;
+			page->pOwners = (uint32_t*)(p + headerSize);
+			page->pData = p + Align(headerSize + capacity * sizeof(uint32_t), 16);
+			page->capacity = capacity;
+			page->usedCount = 0;
+			page->freeSlot = 0;
+
+			for (uint32_t i = 0; i < capacity; i++) {
+				page->pOwners[i] = SMM_INVALID_HANDLE_SLOT;
+				*((uint32_t*)(page->pData + i * elementSize)) = (i + 1 < capacity) ? (i + 1) : SMM_INVALID_HANDLE_SLOT;
+			}
 
-		for (i = 0; i < bucketsDataBegin.size(); i++) {
-			bucketsDataBegin[i] = nullptr;
+			return page;
 		}
 
-		size_t totalBytesCount = bucketSizeInBytes * bucketsCount;
+		uint8_t* AllocHandleSlot(HandlePage* page, uint32_t elementSize, uint32_t owner, uint32_t* pSlot) {
+			SM_ASSERT(page->freeSlot != SMM_INVALID_HANDLE_SLOT);
+
+			uint32_t slot = page->freeSlot;
+			uint8_t* p = page->pData + slot * elementSize;
+
+			page->freeSlot = *((uint32_t*)p);
+			page->pOwners[slot] = owner;
+			page->usedCount++;
+			*pSlot = slot;
 
-		pBuffer.reset((uint8_t*)GenericAllocator::Alloc(gAllocator, totalBytesCount, alignmentMax));
-		pBufferEnd = pBuffer.get() + totalBytesCount + 1;
+			return p;
+		}
 
-		size_t elementSize = 16;
+		void FreeHandleSlot(HandlePage* page, uint32_t elementSize, uint32_t slot) {
+			*((uint32_t*)(page->pData + slot * elementSize)) = page->freeSlot;
+			page->pOwners[slot] = SMM_INVALID_HANDLE_SLOT;
+			page->freeSlot = slot;
+			page->usedCount--;
+		}
 
-		for (i = 0; i < bucketsCount; i++) {
-			PoolBucket& bucket = buckets[i];
-			bucket.pData = pBuffer.get() + i * bucketSizeInBytes;
+		size_t FindHandlePage(HandleClass& handleClass) {
+			size_t i = handleClass.firstFreePage;
 
-			SM_ASSERT(IsAligned((size_t)bucket.pData, GetNextPow2(elementSize)) && "Alignment failed");
+			while (i < handleClass.pages.size() && handleClass.pages[i]->usedCount == handleClass.pages[i]->capacity) {
+				i++;
+			}
 
-			bucket.pBufferEnd = bucket.pData + bucketSizeInBytes;
-			bucket.Create(elementSize);
-			elementSize += 16;
-			bucketsDataBegin[i] = bucket.pData;
+			handleClass.firstFreePage = i;
+
+			return i;
 		}
 	}
+
+	template class BasicAllocator<DefaultConfig>;
 }
 
 sm::GenericAllocator::TInstance sm::GenericAllocator::Invalid() {
@@ -264,6 +533,9 @@ void sm::GenericAllocator::Free(sm::GenericAllocator::TInstance instance, void*
 void* sm::GenericAllocator::Realloc(sm::GenericAllocator::TInstance instance, void* p, size_t bytesCount, size_t alignment) {
 	SMMALLOC_UNUSED(instance);
 
+	if (alignment < 16)
+		alignment = 16;
+
 	return _aligned_realloc(p, bytesCount, alignment);
 }
 
@@ -26,9 +26,13 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
+#include <thread>
+#include <vector>
 
 #if __GNUC__ || __INTEL_COMPILER
 	#define SM_UNLIKELY(expr) __builtin_expect(!!(expr), (0))
@@ -42,16 +46,38 @@
 	#define SMMALLOC_ENABLE_ASSERTS
 #endif
 
-#ifdef _M_X64
+#if defined(_M_X64) || defined(_M_ARM64) || defined(_WIN64) || defined(__x86_64__) || defined(__aarch64__) || defined(__LP64__)
 	#define SMMMALLOC_X64
-	#define SMM_MAX_CACHE_ITEMS_COUNT (7)
 #else
 	#define SMMMALLOC_X86
-	#define SMM_MAX_CACHE_ITEMS_COUNT (10)
 #endif
 
+// Compile-time configuration of the default allocator, these values change its layout, so they must match the ones the library is built with
+#ifndef SMM_MAX_CACHE_ITEMS_COUNT
+	// Depth of the first level thread cache stored in the cache line of a bucket state
+	#ifdef SMMMALLOC_X64
+		#define SMM_MAX_CACHE_ITEMS_COUNT (7)
+	#else
+		#define SMM_MAX_CACHE_ITEMS_COUNT (10)
+	#endif
+#endif
+
+#ifndef SMM_CACHE_L0_EXTENSION_SIZE
+	// Bytes of extra first level slots per thread, shared by the smallest classes in inverse proportion to the element size and taken from the largest classes
+	#define SMM_CACHE_L0_EXTENSION_SIZE (512)
+#endif
+
+#define SMM_CACHE_L0_EXTENSION_BUCKETS (4)
+
 #define SMM_CACHE_LINE_SIZE (64)
 #define SMM_MAX_BUCKET_COUNT (64)
+#define SMM_MAX_INIT_THREADS_COUNT (8)
+#define SMM_TINY_BUCKET_COUNT (2)
+#define SMM_MAX_TINY_ELEMENT_SIZE (8)
+
+#define SMM_HANDLE_PAGE_SIZE (64 * 1024)
+#define SMM_INVALID_HANDLE_SLOT (UINT32_MAX)
+#define SMM_COMPACT_CLOCK_INTERVAL (64)
 
 #define SMMALLOC_UNUSED(x) (void)(x)
 #define SMMALLOC_USED_IN_ASSERT(x) (void)(x)
@@ -68,6 +94,10 @@
 	#define NOINLINE __attribute__((__noinline__))
 #endif
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	#include <intrin.h>
+#endif
+
 #ifdef SMMALLOC_ENABLE_ASSERTS
 	#include <assert.h>
 
@@ -77,64 +107,28 @@
 #endif
 
 namespace sm {
-	#ifdef SMMALLOC_STATS_SUPPORT
-		struct AllocatorStats {
-			std::atomic<size_t> cacheHitCount;
-			std::atomic<size_t> hitCount;
-			std::atomic<size_t> missCount;
-			std::atomic<size_t> freeCount;
-
-			AllocatorStats() {
-				cacheHitCount.store(0);
-				hitCount.store(0);
-				missCount.store(0);
-				freeCount.store(0);
-			}
-		};
-	#endif
-
 	enum CacheWarmupOptions {
 		CACHE_COLD = 0,
 		CACHE_WARM = 1,
-		CACHE_HOT = 2
+		CACHE_HOT = 2,
+		CACHE_RESERVED = 3
 	};
 
-	namespace internal {
-		struct TlsPoolBucket;
-	}
-
-	internal::TlsPoolBucket* __restrict GetTlsBucket(size_t index);
-
-	INLINE bool IsAligned(size_t v, size_t alignment) {
-		size_t lowBits = v & (alignment - 1);
-
-		return (lowBits == 0);
-	}
-
-	INLINE size_t Align(size_t val, size_t alignment) {
-		SM_ASSERT((alignment & (alignment - 1)) == 0 && "Invalid alignment. Must be power of two.");
-
-		size_t r = (val + (alignment - 1)) & ~(alignment - 1);
-
-		SM_ASSERT(IsAligned(r, alignment) && "Alignment failed.");
-
-		return r;
-	}
-
-	INLINE size_t DetectAlignment(void* p) {
-		uintptr_t v = (uintptr_t)p;
-		size_t ptrBitsCount = sizeof(void*) * 8;
-		size_t i;
-
-		for (i = 0; i < ptrBitsCount; i++) {
-			if (v & 1)
-				break;
-
-			v = v >> 1;
-		}
+	enum AllocatorOptions {
+		ALLOCATOR_DEFAULT = 0,
+		ALLOCATOR_MEMFD = 1 << 0,
+		ALLOCATOR_PREFAULT = 1 << 1,
+		ALLOCATOR_PARALLEL_INIT = 1 << 2,
+		ALLOCATOR_LOCKED = 1 << 3,
+		ALLOCATOR_NO_FALLBACK = 1 << 4,
+		ALLOCATOR_TINY_CLASSES = 1 << 5,
+		ALLOCATOR_WIPE_ON_FREE = 1 << 6
+	};
 
-		return (size_t(1) << i);
-	}
+	struct IoVec {
+		void* base;
+		size_t length;
+	};
 
 	struct GenericAllocator {
 		typedef void* TInstance;
@@ -159,341 +153,390 @@ namespace sm {
 		};
 	};
 
-	class Allocator {
-		private:
-
-		static const size_t MaxValidAlignment = 16384;
+	namespace internal {
+		// Copy kernels by bucket index, each copies the whole element of its class between non-overlapping elements
+		typedef void (*CopyKernel)(void* __restrict pDst, const void* __restrict pSrc);
+
+		extern const CopyKernel copyKernels[SMM_MAX_BUCKET_COUNT];
+
+		void WipeMemory(void* p, size_t bytesCount);
+
+		// Platform specific parts of the arena and io_uring registration, shared by all configurations
+		uint8_t* AllocateArena(GenericAllocator::TInstance instance, size_t bytesCount, size_t alignment, uint32_t options, size_t* pMappedBytesCount, int* pFd);
+		void FreeArena(GenericAllocator::TInstance instance, uint8_t* p, size_t mappedBytesCount, size_t lockedBytesCount, int fd);
+		bool LockArena(uint8_t* p, size_t bytesCount);
+		bool RegisterIoRing(int ringFd, const IoVec* pBuffers, uint32_t buffersCount);
+		bool UnregisterIoRing(int ringFd);
+
+		// Kernels cover multiples of 16 bytes up to the largest default class, other sizes of custom classes are copied with memcpy
+		INLINE void CopyBlock(void* __restrict pDst, const void* __restrict pSrc, size_t bytesCount) {
+			if ((bytesCount & 15) == 0 && bytesCount - 1 < SMM_MAX_BUCKET_COUNT * 16)
+				copyKernels[(bytesCount - 1) >> 4](pDst, pSrc);
+			else
+				std::memcpy(pDst, pSrc, bytesCount);
+		}
 
-		friend struct internal::TlsPoolBucket;
+		// Mirrors the part of std::atomic used by the allocator with plain loads and stores
+		template<typename T>
+		struct PlainAtomic {
+			T value;
 
-		INLINE bool IsReadable(void* p) const {
-			return (uintptr_t(p) > MaxValidAlignment);
-		}
+			PlainAtomic() { }
+			PlainAtomic(T _value) : value(_value) { }
 
-		struct PoolBucket {
-			union TaggedIndex {
-				struct {
-					uint32_t tag;
-					uint32_t offset;
-				} p;
+			INLINE T load(std::memory_order order = std::memory_order_seq_cst) const {
+				SMMALLOC_UNUSED(order);
 
-				uint64_t u;
+				return value;
+			}
 
-				static const uint64_t Invalid = UINT64_MAX;
-			};
+			INLINE void store(T _value, std::memory_order order = std::memory_order_seq_cst) {
+				SMMALLOC_UNUSED(order);
 
-			std::atomic<uint64_t> head;
-			std::atomic<uint32_t> globalTag;
+				value = _value;
+			}
 
-			uint8_t* pData;
-			uint8_t* pBufferEnd;
+			INLINE bool compare_exchange_strong(T& expected, T desired, std::memory_order order = std::memory_order_seq_cst) {
+				SMMALLOC_UNUSED(order);
 
-			#ifdef SMMALLOC_STATS_SUPPORT
-				AllocatorStats stats;
-			#endif
+				if (value != expected) {
+					expected = value;
 
-			PoolBucket() : head(TaggedIndex::Invalid), globalTag(0), pData(nullptr), pBufferEnd(nullptr) { }
+					return false;
+				}
 
-			void Create(size_t elementSize);
+				value = desired;
 
-			INLINE void* Alloc() {
-				uint8_t* p = nullptr;
+				return true;
+			}
 
-				TaggedIndex headValue;
-				headValue.u = head.load();
+			INLINE bool compare_exchange_weak(T& expected, T desired, std::memory_order order = std::memory_order_seq_cst) {
+				return compare_exchange_strong(expected, desired, order);
+			}
 
-				while (true) {
-					if (headValue.u == TaggedIndex::Invalid)
-						return nullptr;
+			INLINE T fetch_add(T _value, std::memory_order order = std::memory_order_seq_cst) {
+				SMMALLOC_UNUSED(order);
 
-					p = (pData + headValue.p.offset);
-					TaggedIndex nextValue = *((TaggedIndex*)(p));
+				T previous = value;
 
-					if (head.compare_exchange_strong(headValue.u, nextValue.u))
-						break;
-				}
+				value += _value;
 
-				return p;
+				return previous;
 			}
 
-			INLINE void FreeInterval(void* _pHead, void* _pTail) {
-				uint8_t* pHead = (uint8_t*)_pHead;
-				uint8_t* pTail = (uint8_t*)_pTail;
-				uint32_t tag = globalTag.fetch_add(1, std::memory_order_relaxed);
-
-				TaggedIndex nodeValue;
-				nodeValue.p.offset = (uint32_t)(pHead - pData);
-				nodeValue.p.tag = tag;
-				TaggedIndex headValue;
-				headValue.u = head.load();
+			INLINE T fetch_or(T _value, std::memory_order order = std::memory_order_seq_cst) {
+				SMMALLOC_UNUSED(order);
 
-				while (true) {
-					*((TaggedIndex*)(pTail)) = headValue;
+				T previous = value;
 
-					if (head.compare_exchange_strong(headValue.u, nodeValue.u))
-						break;
-				}
-			}
+				value |= _value;
 
-			INLINE bool IsMyAlloc(void* p) const {
-				return (p >= pData && p < pBufferEnd);
+				return previous;
 			}
 		};
+	}
 
-		public:
+	INLINE bool IsAligned(size_t v, size_t alignment) {
+		size_t lowBits = v & (alignment - 1);
 
-		void CreateThreadCache(CacheWarmupOptions warmupOptions, size_t cacheSize);
-		void DestroyThreadCache();
+		return (lowBits == 0);
+	}
 
-		private:
+	INLINE size_t Align(size_t val, size_t alignment) {
+		SM_ASSERT((alignment & (alignment - 1)) == 0 && "Invalid alignment. Must be power of two.");
 
-		size_t bucketsCount;
-		size_t bucketSizeInBytes;
-		uint8_t* pBufferEnd;
+		size_t r = (val + (alignment - 1)) & ~(alignment - 1);
 
-		std::array<uint8_t*, SMM_MAX_BUCKET_COUNT> bucketsDataBegin;
-		std::array<PoolBucket, SMM_MAX_BUCKET_COUNT> buckets;
-		std::unique_ptr<uint8_t, GenericAllocator::Deleter> pBuffer;
-		GenericAllocator::TInstance gAllocator;
+		SM_ASSERT(IsAligned(r, alignment) && "Alignment failed.");
 
-		#ifdef SMMALLOC_STATS_SUPPORT
-			std::atomic<size_t> globalMissCount;
-		#endif
+		return r;
+	}
 
-		INLINE void* AllocFromCache(internal::TlsPoolBucket* __restrict _self) const;
+	// The size class function, maps a size to the index of the first bucket which fits it, usable for sizes known at compile time
+	constexpr size_t GetSizeClass(size_t bytesCount, size_t alignment) {
+		return (((bytesCount < alignment) ? alignment : bytesCount) - 1) >> 4;
+	}
 
-		template<bool useCacheL0>
-		INLINE bool ReleaseToCache(internal::TlsPoolBucket* __restrict _self, void* _p);
+	INLINE uint32_t FindFirstSet(uint64_t v) {
+		SM_ASSERT(v != 0);
 
-		INLINE size_t FindBucket(const void* p) const {
-			uintptr_t index = (uintptr_t)p - (uintptr_t)bucketsDataBegin[0];
-			size_t r = (index / bucketSizeInBytes);
+		#if __GNUC__ || __INTEL_COMPILER
+			return (uint32_t)__builtin_ctzll(v);
+		#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+			unsigned long index;
 
-			return r;
-		}
+			_BitScanForward64(&index, v);
 
-		INLINE PoolBucket* GetBucketByIndex(size_t bucketIndex) {
-			if (bucketIndex >= bucketsCount)
-				return nullptr;
+			return (uint32_t)index;
+		#else
+			uint32_t i = 0;
 
-			return &buckets[bucketIndex];
-		}
+			while ((v & 1) == 0) {
+				v = v >> 1;
+				i++;
+			}
 
-		INLINE const PoolBucket* GetBucketByIndex(size_t bucketIndex) const {
-			if (bucketIndex >= bucketsCount)
-				return nullptr;
+			return i;
+		#endif
+	}
 
-			return &buckets[bucketIndex];
-		}
+	// Wide offsets count elements in units of the largest power of two dividing the element size instead of bytes
+	INLINE size_t ShiftOffset(uint32_t offset, uint8_t shift) {
+		#ifdef SMMALLOC_WIDE_OFFSETS
+			return ((size_t)offset << shift);
+		#else
+			SMMALLOC_UNUSED(shift);
 
-		template<bool enableStatistic>
-		INLINE void* Allocate(size_t _bytesCount, size_t alignment) {
-			SM_ASSERT(alignment <= MaxValidAlignment);
+			return offset;
+		#endif
+	}
 
-			if (SM_UNLIKELY(_bytesCount == 0))
-				return (void*)alignment;
+	INLINE uint32_t UnshiftOffset(size_t offset, uint8_t shift) {
+		#ifdef SMMALLOC_WIDE_OFFSETS
+			return (uint32_t)(offset >> shift);
+		#else
+			SMMALLOC_UNUSED(shift);
 
-			size_t bytesCount = (_bytesCount < alignment) ? alignment : _bytesCount;
-			size_t bucketIndex = ((bytesCount - 1) >> 4);
+			return (uint32_t)offset;
+		#endif
+	}
 
-			if (bucketIndex < bucketsCount) {
-				void* pRes = AllocFromCache(GetTlsBucket(bucketIndex));
+	INLINE size_t DetectAlignment(void* p) {
+		uintptr_t v = (uintptr_t)p;
+		size_t ptrBitsCount = sizeof(void*) * 8;
+		size_t i;
 
-				if (pRes) {
-					#ifdef SMMALLOC_STATS_SUPPORT
-						if (enableStatistic)
-							buckets[bucketIndex].stats.cacheHitCount.fetch_add(1, std::memory_order_relaxed);
-					#endif
+		for (i = 0; i < ptrBitsCount; i++) {
+			if (v & 1)
+				break;
 
-					return pRes;
-				}
-			}
+			v = v >> 1;
+		}
 
-			while (bucketIndex < bucketsCount) {
-				void* pRes = buckets[bucketIndex].Alloc();
+		return (size_t(1) << i);
+	}
 
-				if (pRes) {
-					#ifdef SMMALLOC_STATS_SUPPORT
-						if (enableStatistic)
-							buckets[bucketIndex].stats.hitCount.fetch_add(1, std::memory_order_relaxed);
-					#endif
+	// Threading policies, a single threaded allocator is used by one thread at a time and its buckets use plain operations instead of atomic ones
+	struct MultiThreaded {
+		static const bool IsConcurrent = true;
 
-					return pRes;
-				} else {
-					#ifdef SMMALLOC_STATS_SUPPORT
-						if (enableStatistic)
-							buckets[bucketIndex].stats.missCount.fetch_add(1, std::memory_order_relaxed);
-					#endif
-				}
+		template<typename T>
+		using Atomic = std::atomic<T>;
+	};
 
-				bucketIndex++;
-			}
+	struct SingleThreaded {
+		static const bool IsConcurrent = false;
 
-			#ifdef SMMALLOC_STATS_SUPPORT
-				if (enableStatistic)
-					globalMissCount.fetch_add(1, std::memory_order_relaxed);
-			#endif
+		template<typename T>
+		using Atomic = internal::PlainAtomic<T>;
+	};
 
-			return GenericAllocator::Alloc(gAllocator, _bytesCount, alignment);
+	// Stats policies, each bucket keeps its own counters and the allocator keeps the misses of all buckets
+	struct AllocatorStats {
+		std::atomic<size_t> cacheHitCount;
+		std::atomic<size_t> hitCount;
+		std::atomic<size_t> missCount;
+		std::atomic<size_t> freeCount;
+
+		AllocatorStats() {
+			cacheHitCount.store(0);
+			hitCount.store(0);
+			missCount.store(0);
+			freeCount.store(0);
 		}
 
-		public:
-
-		Allocator(GenericAllocator::TInstance allocator);
-
-		void Init(uint32_t bucketsCount, size_t bucketSizeInBytes);
-
-		INLINE void* Alloc(size_t _bytesCount, size_t alignment) {
-			return Allocate<true>(_bytesCount, alignment);
+		INLINE void OnCacheHit() {
+			cacheHitCount.fetch_add(1, std::memory_order_relaxed);
 		}
 
-		INLINE void Free(void* p) {
-			if (SM_UNLIKELY(!IsReadable(p)))
-				return;
+		INLINE void OnHit() {
+			hitCount.fetch_add(1, std::memory_order_relaxed);
+		}
 
-			size_t bucketIndex = FindBucket(p);
+		INLINE void OnMiss() {
+			missCount.fetch_add(1, std::memory_order_relaxed);
+		}
 
-			if (bucketIndex < bucketsCount) {
-				#ifdef SMMALLOC_STATS_SUPPORT
-					buckets[bucketIndex].stats.freeCount.fetch_add(1, std::memory_order_relaxed);
-				#endif
+		INLINE void OnFree() {
+			freeCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	};
 
-				if (ReleaseToCache<true>(GetTlsBucket(bucketIndex), p))
-					return;
+	struct NoStats {
+		INLINE void OnCacheHit() { }
+		INLINE void OnHit() { }
+		INLINE void OnMiss() { }
+		INLINE void OnFree() { }
+	};
 
-				PoolBucket* bucket = &buckets[bucketIndex];
-				bucket->FreeInterval(p, p);
+	// Free-list engine of a pool bucket, free elements hold tagged links to each other, the tag of the head defeats ABA on concurrent exchanges
+	template<typename Threading>
+	struct TaggedFreeList {
+		union TaggedIndex {
+			struct {
+				uint32_t tag;
+				uint32_t offset;
+			} p;
 
-				return;
-			}
+			uint64_t u;
 
-			GenericAllocator::Free(gAllocator, (uint8_t*)p);
-		}
+			static const uint64_t Invalid = UINT64_MAX;
+		};
 
-		INLINE void* Realloc(void* p, size_t bytesCount, size_t alignment) {
-			if (p == nullptr)
-				return Alloc(bytesCount, alignment);
+		typename Threading::template Atomic<uint64_t> head;
+		typename Threading::template Atomic<uint32_t> globalTag;
 
-			size_t bucketIndex = FindBucket(p);
+		uint8_t* pData;
+		uint8_t* pBufferEnd;
+		uint8_t offsetShift;
 
-			if (bucketIndex < bucketsCount) {
-				size_t elementSize = GetBucketElementSize(bucketIndex);
+		TaggedFreeList() : head(TaggedIndex::Invalid), globalTag(0), pData(nullptr), pBufferEnd(nullptr), offsetShift(0) { }
 
-				if (bytesCount <= elementSize) {
-					Free(p);
+		void Create(size_t elementSize);
+		uint32_t AllocBatch(uint32_t* pOffsets, uint32_t maxCount);
 
-					return p;
-				}
+		INLINE uint8_t* GetElement(uint32_t offset) const {
+			return pData + ShiftOffset(offset, offsetShift);
+		}
 
-				void* p2 = Alloc(bytesCount, alignment);
+		INLINE uint32_t GetOffset(const void* p) const {
+			return UnshiftOffset((size_t)((const uint8_t*)p - pData), offsetShift);
+		}
 
-				if (IsReadable(p))
-					std::memmove(p2, p, elementSize);
+		INLINE void* Alloc() {
+			uint8_t* p = nullptr;
 
-				Free(p);
+			TaggedIndex headValue;
+			headValue.u = head.load();
 
-				return p2;
-			}
+			while (true) {
+				if (headValue.u == TaggedIndex::Invalid)
+					return nullptr;
 
-			if (bytesCount == 0) {
-				if (IsReadable(p))
-					GenericAllocator::Free(gAllocator, p);
+				p = GetElement(headValue.p.offset);
+				TaggedIndex nextValue = *((TaggedIndex*)(p));
 
-				return (void*)alignment;
+				if (head.compare_exchange_strong(headValue.u, nextValue.u))
+					break;
 			}
 
-			if (!IsReadable(p))
-				return GenericAllocator::Alloc(gAllocator, bytesCount, alignment);
-
-			return GenericAllocator::Realloc(gAllocator, p, bytesCount, alignment);
+			return p;
 		}
 
-		INLINE size_t GetUsableSize(void* p) {
-			if (!IsReadable(p))
-				return 0;
+		INLINE void FreeInterval(void* _pHead, void* _pTail) {
+			uint8_t* pHead = (uint8_t*)_pHead;
+			uint8_t* pTail = (uint8_t*)_pTail;
+			uint32_t tag = globalTag.fetch_add(1, std::memory_order_relaxed);
 
-			size_t bucketIndex = FindBucket(p);
+			TaggedIndex nodeValue;
+			nodeValue.p.offset = GetOffset(pHead);
+			nodeValue.p.tag = tag;
+			TaggedIndex headValue;
+			headValue.u = head.load();
 
-			if (bucketIndex < bucketsCount) {
-				size_t elementSize = GetBucketElementSize(bucketIndex);
+			while (true) {
+				*((TaggedIndex*)(pTail)) = headValue;
 
-				return elementSize;
+				if (head.compare_exchange_strong(headValue.u, nodeValue.u))
+					break;
 			}
-
-			return GenericAllocator::GetUsableSpace(gAllocator, p);
 		}
 
-		INLINE int32_t GetBucketIndex(void* _p) {
-			if (!IsMyAlloc(_p))
-				return -1;
+		// Elements are linked in order before the chain is published with a single exchange
+		INLINE void FreeBatch(const uint32_t* pOffsets, uint32_t count) {
+			if (count == 0)
+				return;
 
-			size_t bucketIndex = FindBucket(_p);
+			uint32_t localTag = 0xFFFFFF;
+			uint8_t* pHead = GetElement(pOffsets[0]);
+			uint8_t* pPrevBlockMemory = pHead;
 
-			if (bucketIndex >= bucketsCount)
-				return -1;
+			for (uint32_t i = 1; i < count; i++, localTag++) {
+				TaggedIndex* pTag = (TaggedIndex*)pPrevBlockMemory;
+				pTag->p.tag = localTag;
+				pTag->p.offset = pOffsets[i];
 
-			return (int32_t)bucketIndex;
-		}
+				pPrevBlockMemory = GetElement(pOffsets[i]);
+			}
 
-		INLINE bool IsMyAlloc(const void* p) const {
-			return (p >= pBuffer.get() && p < pBufferEnd);
+			FreeInterval(pHead, pPrevBlockMemory);
 		}
 
-		INLINE size_t GetBucketsCount() const {
-			return bucketsCount;
+		INLINE bool IsMyAlloc(const void* p) const {
+			return (p >= pData && p < pBufferEnd);
 		}
+	};
 
-		INLINE uint32_t GetBucketElementSize(size_t bucketIndex) const {
-			return (uint32_t)((bucketIndex + 1) * 16);
-		}
+	// Compile-time configuration of BasicAllocator, a custom configuration derives from this one and redefines what it changes
+	struct DefaultConfig {
+		// Depth of the first level thread cache stored in the cache line of a bucket state
+		static const uint32_t CacheItemsCount = SMM_MAX_CACHE_ITEMS_COUNT;
 
-		INLINE uint32_t GetBucketElementsCount(size_t bucketIndex) const {
-			if (bucketIndex >= bucketsCount)
-				return 0;
+		// Bytes of extra first level slots per thread, shared by the smallest classes and taken from the depth of the largest ones
+		static const uint32_t CacheExtensionSize = SMM_CACHE_L0_EXTENSION_SIZE;
 
-			size_t oneElementSize = GetBucketElementSize(bucketIndex);
+		// Upper limit of the buckets count accepted by Init
+		static const uint32_t MaxBucketsCount = SMM_MAX_BUCKET_COUNT;
 
-			return (uint32_t)(bucketSizeInBytes / oneElementSize);
-		}
+		typedef MultiThreaded Threading;
+		typedef TaggedFreeList<Threading> FreeList;
 
 		#ifdef SMMALLOC_STATS_SUPPORT
-			size_t GetGlobalMissCount() const {
-				return globalMissCount.load(std::memory_order_relaxed);
-			}
-
-			const AllocatorStats* GetBucketStats(size_t bucketIndex) const {
-				const PoolBucket* bucket = GetBucketByIndex(bucketIndex);
-
-				if (!bucket)
-					return nullptr;
-
-				return &bucket->stats;
-			}
+			typedef AllocatorStats Stats;
+		#else
+			typedef NoStats Stats;
 		#endif
 
-		GenericAllocator::TInstance GetGenericAllocatorInstance() {
-			return gAllocator;
+		// Element sizes must be multiples of 16 bytes which grow with the bucket index, the size class function is their inverse
+		static constexpr size_t GetSizeClass(size_t bytesCount, size_t alignment) {
+			return sm::GetSizeClass(bytesCount, alignment);
+		}
+
+		static constexpr uint32_t GetElementSize(size_t bucketIndex) {
+			return (uint32_t)((bucketIndex + 1) * 16);
 		}
 	};
 
+	template<typename Config>
+	class BasicAllocator;
+
 	namespace internal {
-		struct TlsPoolBucket {
+		enum TlsPoolBucketFlags {
+			CACHE_BUCKET_RESERVED = 1 << 0,
+			CACHE_BUCKET_HANDOFF = 1 << 1
+		};
+
+		template<typename Config>
+		struct alignas(SMM_CACHE_LINE_SIZE) TlsPoolBucket {
+			typedef typename Config::FreeList PoolBucket;
+
 			uint8_t* pBucketData;
 			uint32_t* pStorageL1;
 
-			Allocator::PoolBucket* pBucket;
-			std::array<uint32_t, SMM_MAX_CACHE_ITEMS_COUNT> storageL0;
+			PoolBucket* pBucket;
+			std::array<uint32_t, Config::CacheItemsCount> storageL0;
 
 			uint32_t maxElementsCount;
 			uint32_t numElementsL1;
 			uint8_t numElementsL0;
+			uint8_t maxElementsL0;
+			uint8_t offsetShift;
+			uint8_t flags;
 
 			INLINE uint32_t GetElementsCount() const {
 				return numElementsL1 + numElementsL0;
 			}
 
-			void Init(uint32_t* pCacheStack, uint32_t maxElementsNum, CacheWarmupOptions warmupOptions, Allocator* alloc, size_t bucketIndex);
-			uint32_t* Destroy();
+			INLINE uint32_t& GetStorageL0(uint32_t index) {
+				if (SM_LIKELY(index < Config::CacheItemsCount))
+					return storageL0[index];
+
+				// Slots of small classes beyond the inline ones extend downwards from the second level stack
+				return *(pStorageL1 - (index - Config::CacheItemsCount) - 1);
+			}
+
+			void Init(uint32_t* pCacheStack, uint32_t maxElementsNum, uint8_t maxElementsNumL0, CacheWarmupOptions warmupOptions, PoolBucket* poolBucket);
+			void Destroy();
 
 			INLINE void ReturnL1CacheToMaster(uint32_t count) {
 				if (count == 0)
@@ -506,108 +549,1954 @@ namespace sm {
 
 				count = std::min(count, numElementsL1);
 
-				uint32_t localTag = 0xFFFFFF;
 				uint32_t firstElementToReturn = (numElementsL1 - count);
-				uint32_t offset = pStorageL1[firstElementToReturn];
-				uint8_t* pHead = pBucketData + offset;
-				uint8_t* pPrevBlockMemory = pHead;
-
-				for (uint32_t i = (firstElementToReturn + 1); i < numElementsL1; i++, localTag++) {
-					offset = pStorageL1[i];
-					Allocator::PoolBucket::TaggedIndex* pTag = (Allocator::PoolBucket::TaggedIndex*)pPrevBlockMemory;
-					pTag->p.tag = localTag;
-					pTag->p.offset = offset;
-
-					uint8_t* pBlockMemory = pBucketData + offset;
-
-					pPrevBlockMemory = pBlockMemory;
-				}
-
-				uint8_t* pTail = pPrevBlockMemory;
 
-				pBucket->FreeInterval(pHead, pTail);
+				pBucket->FreeBatch(pStorageL1 + firstElementToReturn, count);
 				numElementsL1 -= count;
 			}
+
+		};
+
+		struct HandlePage {
+			uint8_t* pData;
+			uint32_t* pOwners;
+			uint32_t capacity;
+			uint32_t usedCount;
+			uint32_t freeSlot;
+		};
+
+		struct HandleEntry {
+			uint8_t* p;
+			HandlePage* pPage;
+			size_t bytesCount;
+			uint32_t generation;
+			uint32_t slot;
+			uint32_t locksCount;
+			uint32_t nextFree;
+		};
+
+		struct HandleClass {
+			std::vector<HandlePage*> pages;
+			size_t firstFreePage;
+
+			HandleClass() : firstFreePage(0) { }
+		};
+
+		// Generations are odd while a handle is alive, so a handle of zero is never valid
+		struct HandleHeap {
+			std::mutex mutex;
+			std::vector<HandleEntry> entries;
+			std::array<HandleClass, SMM_MAX_BUCKET_COUNT> classes;
+			uint32_t freeEntry;
+			size_t compactClassIndex;
+
+			HandleHeap() : freeEntry(SMM_INVALID_HANDLE_SLOT), compactClassIndex(0) { }
+
+			INLINE HandleEntry* Find(uint64_t handle) {
+				uint32_t index = (uint32_t)handle;
+				uint32_t generation = (uint32_t)(handle >> 32);
+
+				if (index >= entries.size() || entries[index].generation != generation || (generation & 1) == 0)
+					return nullptr;
+
+				return &entries[index];
+			}
+		};
+
+		HandlePage* CreateHandlePage(GenericAllocator::TInstance instance, uint32_t elementSize);
+		uint8_t* AllocHandleSlot(HandlePage* page, uint32_t elementSize, uint32_t owner, uint32_t* pSlot);
+		void FreeHandleSlot(HandlePage* page, uint32_t elementSize, uint32_t slot);
+		size_t FindHandlePage(HandleClass& handleClass);
+	}
+
+	template<typename Config>
+	class BasicAllocator {
+		private:
+
+		static const size_t MaxValidAlignment = 16384;
+
+		static_assert(Config::MaxBucketsCount > 0 && Config::MaxBucketsCount <= SMM_MAX_BUCKET_COUNT, "Buckets are selected by 64-bit masks");
+
+		template<typename T>
+		using Atomic = typename Config::Threading::template Atomic<T>;
+
+		public:
+
+		typedef internal::TlsPoolBucket<Config> TlsBucket;
+
+		static_assert(std::is_pod<TlsBucket>::value == true, "TlsPoolBucket must be POD type, stored in TLS");
+		static_assert(sizeof(TlsBucket) <= SMM_CACHE_LINE_SIZE, "TlsPoolBucket sizeof must be less than CPU cache line, CacheItemsCount is too large");
+
+		private:
+
+		INLINE bool IsReadable(void* p) const {
+			return (uintptr_t(p) > MaxValidAlignment);
+		}
+
+		struct PoolBucket : public Config::FreeList {
+			typename Config::Stats stats;
+		};
+
+		// Elements below 16 bytes can't hold a tagged index, so free elements are tracked by a bitmap outside of the data
+		struct TinyBucket {
+			Atomic<uint64_t>* pFreeMask;
+			Atomic<uint32_t> hint;
+			uint32_t wordsCount;
+			uint32_t elementSize;
+
+			uint8_t* pData;
+			uint8_t* pBufferEnd;
+
+			TinyBucket() : pFreeMask(nullptr), hint(0), wordsCount(0), elementSize(0), pData(nullptr), pBufferEnd(nullptr) { }
+
+			void Create(Atomic<uint64_t>* pMask, size_t elementsCount);
+
+			INLINE void* Alloc() {
+				uint32_t firstWordIndex = hint.load(std::memory_order_relaxed);
+
+				for (uint32_t i = 0; i < wordsCount; i++) {
+					uint32_t wordIndex = firstWordIndex + i;
+
+					if (wordIndex >= wordsCount)
+						wordIndex -= wordsCount;
+
+					uint64_t mask = pFreeMask[wordIndex].load(std::memory_order_relaxed);
+
+					while (mask != 0) {
+						uint64_t bit = mask & (~mask + 1);
+
+						if (pFreeMask[wordIndex].compare_exchange_weak(mask, mask & ~bit)) {
+							if (wordIndex != firstWordIndex)
+								hint.store(wordIndex, std::memory_order_relaxed);
+
+							return pData + ((size_t)wordIndex * 64 + FindFirstSet(bit)) * elementSize;
+						}
+					}
+				}
+
+				return nullptr;
+			}
+
+			INLINE void Free(void* p) {
+				size_t index = (size_t)((uint8_t*)p - pData) / elementSize;
+
+				pFreeMask[index >> 6].fetch_or(uint64_t(1) << (index & 63));
+			}
+
+			INLINE bool IsMyAlloc(const void* p) const {
+				return (p >= pData && p < pBufferEnd);
+			}
+		};
+
+		// Header of a single per-thread block, followed by the cache state of configured buckets and their L1 stacks in order of bucket indices, smallest and usually hottest classes first
+		struct ThreadCache {
+			uint32_t bucketsCount;
+			uint32_t warmupOptions;
+			size_t handoffDistance;
+			std::atomic<uint64_t> readyMask;
+			std::atomic<bool> cancelled;
+			std::thread* pWarmupThread;
+
+			INLINE TlsBucket* GetBuckets() {
+				return (TlsBucket*)((uint8_t*)this + SMM_CACHE_LINE_SIZE);
+			}
+		};
+
+		static_assert(sizeof(ThreadCache) <= SMM_CACHE_LINE_SIZE, "ThreadCache header must fit CPU cache line");
+
+		struct ThreadCacheGuard {
+			BasicAllocator* pOwner;
+			uint64_t ownerId;
+
+			ThreadCacheGuard() : pOwner(nullptr), ownerId(0) { }
+			~ThreadCacheGuard();
+
+			static void Release();
+		};
+
+		// Threads without a cache share the zeroed state, which is never written since its capacity is zero
+		static ThreadCache emptyThreadCache;
+		static TlsBucket emptyCacheBucket;
+
+		// Thread locals are function statics, so users of the library instantiation don't rely on its TLS init functions
+		static INLINE ThreadCache*& GetThreadCache() {
+			static thread_local ThreadCache* tlsThreadCache = &emptyThreadCache;
+
+			return tlsThreadCache;
+		}
+
+		static INLINE ThreadCacheGuard& GetCacheGuard() {
+			static thread_local ThreadCacheGuard tlsCacheGuard;
+
+			return tlsCacheGuard;
+		}
+
+		public:
+
+		bool CreateThreadCache(CacheWarmupOptions warmupOptions, size_t cacheSize);
+		bool CreateThreadCache(CacheWarmupOptions warmupOptions, size_t cacheSize, uint64_t bucketsMask);
+		bool CreateThreadCache(CacheWarmupOptions warmupOptions, const uint32_t* pCacheSizes, size_t cacheSizesCount);
+		bool CreateThreadCacheAsync(CacheWarmupOptions warmupOptions, size_t cacheSize);
+		bool CreateThreadCacheAsync(CacheWarmupOptions warmupOptions, size_t cacheSize, uint64_t bucketsMask);
+		bool CreateThreadCacheAsync(CacheWarmupOptions warmupOptions, const uint32_t* pCacheSizes, size_t cacheSizesCount);
+		void DestroyThreadCache();
+
+		uint32_t GetIoBuffers(uint64_t bucketsMask, IoVec* pBuffers, uint32_t maxBuffersCount, uint32_t firstBufferIndex);
+		bool RegisterIoBuffers(int ringFd, uint64_t bucketsMask);
+		bool UnregisterIoBuffers();
+
+		uint64_t AllocHandle(size_t bytesCount);
+		void FreeHandle(uint64_t handle);
+		void* LockHandle(uint64_t handle);
+		void UnlockHandle(uint64_t handle);
+		size_t GetHandleSize(uint64_t handle);
+		size_t Compact(uint64_t budgetMicroseconds);
+
+		static INLINE TlsBucket* __restrict GetTlsBucket(size_t index) {
+			ThreadCache* cache = GetThreadCache();
+
+			if (SM_UNLIKELY(index >= cache->bucketsCount))
+				return &emptyCacheBucket;
+
+			return cache->GetBuckets() + index;
+		}
+
+		// Layout of the configuration as seen by a translation unit, an allocator built with different compile-time values can't share its state
+		static constexpr uint32_t GetLayout() {
+			return (uint32_t)sizeof(BasicAllocator) ^ (Config::CacheItemsCount << 16) ^ (Config::CacheExtensionSize << 20)
+			#ifdef SMMALLOC_WIDE_OFFSETS
+				^ (uint32_t(1) << 31)
+			#endif
+			;
+		}
+
+		private:
+
+		size_t bucketsCount;
+		size_t bucketSizeInBytes;
+		uint8_t* pBufferEnd;
+		int ioRingFd;
+
+		std::array<uint8_t*, Config::MaxBucketsCount> bucketsDataBegin;
+		std::array<int32_t, Config::MaxBucketsCount> ioBufferIndices;
+		std::array<PoolBucket, Config::MaxBucketsCount> buckets;
+		std::array<TinyBucket, SMM_TINY_BUCKET_COUNT> tinyBuckets;
+		struct ArenaDeleter {
+			explicit ArenaDeleter(GenericAllocator::TInstance _instance) : instance(_instance), mappedBytesCount(0), lockedBytesCount(0), fd(-1) { }
+
+			void operator()(uint8_t* p) {
+				internal::FreeArena(instance, p, mappedBytesCount, lockedBytesCount, fd);
+
+				mappedBytesCount = 0;
+				lockedBytesCount = 0;
+				fd = -1;
+			}
+
+			GenericAllocator::TInstance instance;
+			size_t mappedBytesCount;
+			size_t lockedBytesCount;
+			int fd;
 		};
 
-		static_assert(std::is_pod<TlsPoolBucket>::value == true, "TlsPoolBucket must be POD type, stored in TLS");
-		static_assert(sizeof(TlsPoolBucket) <= 64, "TlsPoolBucket sizeof must be less than CPU cache line");
+		uint32_t options;
+		uint64_t instanceId;
+
+		std::unique_ptr<uint8_t, ArenaDeleter> pBuffer;
+		uint8_t* pTinyBuffer;
+		uint8_t* pTinyBufferEnd;
+		GenericAllocator::TInstance gAllocator;
+		std::atomic<internal::HandleHeap*> pHandleHeap;
+		std::atomic<uint32_t> warmupThreadsCount;
+		std::atomic<bool> warmupCancelled;
+		typename Config::Stats globalStats;
+
+		static std::mutex& GetAllocatorsMutex();
+		static std::vector<BasicAllocator*>& GetAllocators();
+		static void StopWarmupThread(ThreadCache* cache);
+		static void AbandonThreadCache();
+		static void GetCacheDepthsL0(const uint32_t* pCacheSizes, size_t cachedBucketsCount, uint8_t* pDepths);
+		static uint32_t GetExtensionL0(uint8_t depthL0);
+
+		internal::HandleHeap* GetHandleHeap();
+		uint8_t* AllocateArena(size_t bytesCount, size_t alignment);
+		bool LockArena(size_t bytesCount);
+		size_t GetTinyBucketsBytesCount() const;
+		void CreateTinyBuckets(uint8_t* pData);
+		void CreateBuckets(size_t firstBucketIndex, size_t lastBucketIndex);
+		bool CreateThreadCacheBlock(CacheWarmupOptions warmupOptions, const uint32_t* pCacheSizes, size_t cacheSizesCount, bool async);
+		void WarmupThreadCache(ThreadCache* cache);
+		NOINLINE bool TakeCacheHandoff(TlsBucket* __restrict _self, size_t bucketIndex);
+
+		INLINE void* AllocFromCache(TlsBucket* __restrict _self) const;
+		INLINE bool IsReservedCache(const TlsBucket* __restrict _self) const;
+		INLINE bool HasCacheHandoff(const TlsBucket* __restrict _self) const;
+
+		template<bool useCacheL0>
+		INLINE bool ReleaseToCache(TlsBucket* __restrict _self, void* _p);
+
+		INLINE size_t FindBucket(const void* p) const {
+			uintptr_t index = (uintptr_t)p - (uintptr_t)bucketsDataBegin[0];
+			size_t r = (index / bucketSizeInBytes);
+
+			return r;
+		}
+
+		INLINE PoolBucket* GetBucketByIndex(size_t bucketIndex) {
+			if (bucketIndex >= bucketsCount)
+				return nullptr;
+
+			return &buckets[bucketIndex];
+		}
+
+		INLINE const PoolBucket* GetBucketByIndex(size_t bucketIndex) const {
+			if (bucketIndex >= bucketsCount)
+				return nullptr;
+
+			return &buckets[bucketIndex];
+		}
+
+		INLINE bool IsTinyAlloc(const void* p) const {
+			return (p >= pTinyBuffer && p < pTinyBufferEnd);
+		}
+
+		INLINE bool IsTinySize(size_t bytesCount) const {
+			return (bytesCount <= SMM_MAX_TINY_ELEMENT_SIZE && pTinyBufferEnd != nullptr);
+		}
+
+		INLINE TinyBucket* FindTinyBucket(const void* p) {
+			SM_ASSERT(IsTinyAlloc(p));
+
+			return tinyBuckets[1].IsMyAlloc(p) ? &tinyBuckets[1] : &tinyBuckets[0];
+		}
+
+		template<bool enableStatistic>
+		INLINE void* Allocate(size_t _bytesCount, size_t alignment) {
+			SM_ASSERT(alignment <= MaxValidAlignment);
+
+			if (SM_UNLIKELY(_bytesCount == 0))
+				return (void*)alignment;
+
+			size_t bytesCount = (_bytesCount < alignment) ? alignment : _bytesCount;
+			size_t bucketIndex = Config::GetSizeClass(bytesCount, alignment);
+
+			// Tiny classes go before the thread cache, otherwise cached threads would serve these sizes from 16 bytes elements
+			if (IsTinySize(bytesCount)) {
+				void* pRes = tinyBuckets[(bytesCount - 1) >> 2].Alloc();
+
+				if (pRes)
+					return pRes;
+			}
+
+			if (bucketIndex < bucketsCount) {
+				TlsBucket* __restrict tlsBucket = GetTlsBucket(bucketIndex);
+				void* pRes = AllocFromCache(tlsBucket);
+
+				if (pRes) {
+					if (enableStatistic)
+						buckets[bucketIndex].stats.OnCacheHit();
+
+					return pRes;
+				}
+
+				if (SM_UNLIKELY(HasCacheHandoff(tlsBucket)) && TakeCacheHandoff(tlsBucket, bucketIndex))
+					return AllocFromCache(tlsBucket);
+
+				if (SM_UNLIKELY(IsReservedCache(tlsBucket)))
+					return nullptr;
+			}
+
+			while (bucketIndex < bucketsCount) {
+				void* pRes = buckets[bucketIndex].Alloc();
+
+				if (pRes) {
+					if (enableStatistic)
+						buckets[bucketIndex].stats.OnHit();
+
+					return pRes;
+				} else {
+					if (enableStatistic)
+						buckets[bucketIndex].stats.OnMiss();
+				}
+
+				bucketIndex++;
+			}
+
+			if (enableStatistic)
+				globalStats.OnMiss();
+
+			if (SM_UNLIKELY(options & ALLOCATOR_NO_FALLBACK))
+				return nullptr;
+
+			return GenericAllocator::Alloc(gAllocator, _bytesCount, alignment);
+		}
+
+		template<bool wipe>
+		INLINE void Deallocate(void* p) {
+			if (SM_UNLIKELY(!IsReadable(p)))
+				return;
+
+			size_t bucketIndex = FindBucket(p);
+
+			if (bucketIndex < bucketsCount) {
+				buckets[bucketIndex].stats.OnFree();
+
+				if (wipe)
+					internal::WipeMemory(p, GetBucketElementSize(bucketIndex));
+
+				if (ReleaseToCache<true>(GetTlsBucket(bucketIndex), p))
+					return;
+
+				PoolBucket* bucket = &buckets[bucketIndex];
+				bucket->FreeInterval(p, p);
+
+				return;
+			}
+
+			if (IsTinyAlloc(p)) {
+				TinyBucket* tinyBucket = FindTinyBucket(p);
+
+				if (wipe)
+					internal::WipeMemory(p, tinyBucket->elementSize);
+
+				tinyBucket->Free(p);
+
+				return;
+			}
+
+			if (wipe)
+				internal::WipeMemory(p, GenericAllocator::GetUsableSpace(gAllocator, p));
+
+			GenericAllocator::Free(gAllocator, (uint8_t*)p);
+		}
+
+		public:
+
+		BasicAllocator(GenericAllocator::TInstance allocator);
+		~BasicAllocator();
+
+		// The layout defaults to the one of the caller, so a consumer built with different compile-time values is rejected
+		bool Init(uint32_t bucketsCount, size_t bucketSizeInBytes, uint32_t options = ALLOCATOR_DEFAULT, uint32_t layout = GetLayout());
+
+		INLINE void* Alloc(size_t _bytesCount, size_t alignment) {
+			return Allocate<true>(_bytesCount, alignment);
+		}
+
+		INLINE void Free(void* p) {
+			if (SM_UNLIKELY(options & ALLOCATOR_WIPE_ON_FREE))
+				Deallocate<true>(p);
+			else
+				Deallocate<false>(p);
+		}
+
+		INLINE void FreeWipe(void* p) {
+			Deallocate<true>(p);
+		}
+
+		template<size_t bytesCount, size_t alignment>
+		INLINE void* AllocFixed() {
+			static_assert(bytesCount > 0, "Allocation size must be positive");
+			static_assert((alignment & (alignment - 1)) == 0 && alignment <= MaxValidAlignment, "Invalid alignment");
+
+			const size_t bucketIndex = Config::GetSizeClass(bytesCount, alignment);
+
+			// Sizes beyond the largest possible bucket go straight to the fallback, tiny sizes take the regular path to their classes
+			if (bucketIndex < Config::MaxBucketsCount && bucketIndex < bucketsCount && !IsTinySize(std::max(bytesCount, alignment))) {
+				void* pRes = AllocFromCache(GetTlsBucket(bucketIndex));
+
+				if (SM_LIKELY(pRes != nullptr)) {
+					buckets[bucketIndex].stats.OnCacheHit();
+
+					return pRes;
+				}
+			}
+
+			return Allocate<true>(bytesCount, alignment);
+		}
+
+		template<size_t bytesCount>
+		INLINE void FreeFixed(void* p) {
+			const size_t bucketIndex = Config::GetSizeClass(bytesCount, 0);
+
+			// Memory blocks of other buckets, tiny classes and the fallback take the generic path
+			if (bucketIndex < Config::MaxBucketsCount && bucketIndex < bucketsCount && (options & ALLOCATOR_WIPE_ON_FREE) == 0 && buckets[bucketIndex].IsMyAlloc(p)) {
+				buckets[bucketIndex].stats.OnFree();
+
+				if (ReleaseToCache<true>(GetTlsBucket(bucketIndex), p))
+					return;
+
+				buckets[bucketIndex].FreeInterval(p, p);
+
+				return;
+			}
+
+			Free(p);
+		}
+
+		INLINE void* Realloc(void* p, size_t bytesCount, size_t alignment) {
+			if (p == nullptr)
+				return Alloc(bytesCount, alignment);
+
+			size_t bucketIndex = FindBucket(p);
+
+			if (bucketIndex < bucketsCount) {
+				size_t elementSize = GetBucketElementSize(bucketIndex);
+
+				if (bytesCount == 0) {
+					Free(p);
+
+					return (void*)alignment;
+				}
+
+				// The element still fits, so the memory block stays live and in place
+				if (bytesCount <= elementSize && IsAligned((size_t)p, std::max(alignment, (size_t)1)))
+					return p;
+
+				void* p2 = Alloc(bytesCount, alignment);
+
+				if (p2 == nullptr)
+					return nullptr;
+
+				size_t capacity = std::max(bytesCount, GetUsableSize(p2));
+
+				// A misaligned element may move into a smaller one, the kernel of the class copies whole elements only
+				if (capacity >= elementSize)
+					internal::CopyBlock(p2, p, elementSize);
+				else
+					std::memcpy(p2, p, capacity);
+
+				Free(p);
+
+				return p2;
+			}
+
+			if (IsTinyAlloc(p)) {
+				TinyBucket* tinyBucket = FindTinyBucket(p);
+
+				if (bytesCount == 0) {
+					Free(p);
+
+					return (void*)alignment;
+				}
+
+				if (bytesCount <= tinyBucket->elementSize && IsAligned((size_t)p, std::max(alignment, (size_t)1)))
+					return p;
+
+				void* p2 = Alloc(bytesCount, alignment);
+
+				if (p2 == nullptr)
+					return nullptr;
+
+				std::memcpy(p2, p, tinyBucket->elementSize);
+				Free(p);
+
+				return p2;
+			}
+
+			if (bytesCount == 0) {
+				Free(p);
+
+				return (void*)alignment;
+			}
+
+			if (!IsReadable(p))
+				return Alloc(bytesCount, alignment);
+
+			// The generic realloc releases the old memory block without wiping it
+			if (SM_UNLIKELY(options & ALLOCATOR_WIPE_ON_FREE)) {
+				void* p2 = GenericAllocator::Alloc(gAllocator, bytesCount, alignment);
+
+				if (p2 == nullptr)
+					return nullptr;
+
+				std::memcpy(p2, p, std::min(bytesCount, GenericAllocator::GetUsableSpace(gAllocator, p)));
+				Deallocate<true>(p);
+
+				return p2;
+			}
+
+			return GenericAllocator::Realloc(gAllocator, p, bytesCount, alignment);
+		}
+
+		INLINE void* Expand(void* p, size_t bytesCount) {
+			if (!IsReadable(p) || bytesCount == 0)
+				return nullptr;
+
+			size_t bucketIndex = FindBucket(p);
+
+			if (bucketIndex < bucketsCount)
+				return (bytesCount <= GetBucketElementSize(bucketIndex)) ? p : nullptr;
+
+			if (IsTinyAlloc(p))
+				return (bytesCount <= FindTinyBucket(p)->elementSize) ? p : nullptr;
+
+			return nullptr;
+		}
+
+		INLINE size_t GetGoodSize(size_t bytesCount) const {
+			if (bytesCount == 0)
+				return 0;
+
+			if (IsTinySize(bytesCount))
+				return tinyBuckets[(bytesCount - 1) >> 2].elementSize;
+
+			size_t bucketIndex = Config::GetSizeClass(bytesCount, 0);
+
+			if (bucketIndex < bucketsCount)
+				return GetBucketElementSize(bucketIndex);
+
+			return bytesCount;
+		}
+
+		INLINE void* Grow(void* p, size_t usedBytes, size_t bytesCount, size_t* pCapacity) {
+			if (Expand(p, bytesCount)) {
+				if (pCapacity)
+					*pCapacity = GetUsableSize(p);
+
+				return p;
+			}
+
+			size_t goodSize = GetGoodSize(bytesCount);
+
+			// Blocks of the generic allocator stay there and may grow in place
+			if (IsReadable(p) && !IsMyAlloc(p) && !IsTinyAlloc(p) && goodSize == bytesCount && (options & ALLOCATOR_WIPE_ON_FREE) == 0) {
+				void* p2 = GenericAllocator::Realloc(gAllocator, p, goodSize, 0);
+
+				if (p2 != nullptr && pCapacity)
+					*pCapacity = goodSize;
+
+				return p2;
+			}
+
+			void* p2 = Alloc(goodSize, 0);
+
+			if (p2 == nullptr)
+				return nullptr;
+
+			size_t capacity = (IsMyAlloc(p2) || IsTinyAlloc(p2)) ? GetUsableSize(p2) : goodSize;
+
+			if (IsReadable(p)) {
+				// Sizes of pooled blocks are exact, so the used prefix is clamped to them before it selects a kernel
+				if (IsMyAlloc(p) || IsTinyAlloc(p))
+					usedBytes = std::min(usedBytes, GetUsableSize(p));
+
+				usedBytes = std::min(usedBytes, capacity);
+
+				// Prefixes of pooled elements are rounded up to 16 bytes, which the source element holds
+				if (IsMyAlloc(p) && usedBytes > 0 && Align(usedBytes, 16) <= capacity)
+					internal::CopyBlock(p2, p, Align(usedBytes, 16));
+				else
+					std::memcpy(p2, p, usedBytes);
+
+				Free(p);
+			}
+
+			if (pCapacity)
+				*pCapacity = capacity;
+
+			return p2;
+		}
+
+		INLINE size_t GetUsableSize(void* p) {
+			if (!IsReadable(p))
+				return 0;
+
+			size_t bucketIndex = FindBucket(p);
+
+			if (bucketIndex < bucketsCount) {
+				size_t elementSize = GetBucketElementSize(bucketIndex);
+
+				return elementSize;
+			}
+
+			if (IsTinyAlloc(p))
+				return FindTinyBucket(p)->elementSize;
+
+			return GenericAllocator::GetUsableSpace(gAllocator, p);
+		}
+
+		INLINE int32_t GetBucketIndex(void* _p) {
+			if (!IsMyAlloc(_p))
+				return -1;
+
+			size_t bucketIndex = FindBucket(_p);
+
+			if (bucketIndex >= bucketsCount)
+				return -1;
+
+			return (int32_t)bucketIndex;
+		}
+
+		INLINE bool IsMyAlloc(const void* p) const {
+			return (p >= pBuffer.get() && p < pBufferEnd);
+		}
+
+		INLINE bool GetIoBuffer(const void* p, uint32_t* pBufferIndex, size_t* pOffset) const {
+			if (!IsMyAlloc(p))
+				return false;
+
+			size_t bucketIndex = FindBucket(p);
+
+			if (bucketIndex >= bucketsCount || ioBufferIndices[bucketIndex] < 0)
+				return false;
+
+			*pBufferIndex = (uint32_t)ioBufferIndices[bucketIndex];
+			*pOffset = (size_t)((const uint8_t*)p - bucketsDataBegin[bucketIndex]);
+
+			return true;
+		}
+
+		INLINE int GetArenaFd(size_t* pArenaSize) const {
+			if (pArenaSize)
+				*pArenaSize = pBuffer.get_deleter().mappedBytesCount;
+
+			return pBuffer.get_deleter().fd;
+		}
+
+		INLINE bool GetArenaBlock(const void* p, int* pFd, size_t* pOffset, size_t* pLength) const {
+			int fd = pBuffer.get_deleter().fd;
+
+			if (fd < 0 || !IsMyAlloc(p))
+				return false;
+
+			size_t bucketIndex = FindBucket(p);
+
+			if (bucketIndex >= bucketsCount)
+				return false;
+
+			*pFd = fd;
+			*pOffset = (size_t)((const uint8_t*)p - pBuffer.get());
+			*pLength = GetBucketElementSize(bucketIndex);
+
+			return true;
+		}
+
+		INLINE size_t GetBucketsCount() const {
+			return bucketsCount;
+		}
+
+		INLINE uint32_t GetBucketElementSize(size_t bucketIndex) const {
+			return Config::GetElementSize(bucketIndex);
+		}
+
+		INLINE uint32_t GetBucketElementsCount(size_t bucketIndex) const {
+			if (bucketIndex >= bucketsCount)
+				return 0;
+
+			size_t oneElementSize = GetBucketElementSize(bucketIndex);
+
+			return (uint32_t)(bucketSizeInBytes / oneElementSize);
+		}
+
+		const typename Config::Stats* GetGlobalStats() const {
+			return &globalStats;
+		}
+
+		const typename Config::Stats* GetBucketStats(size_t bucketIndex) const {
+			const PoolBucket* bucket = GetBucketByIndex(bucketIndex);
+
+			if (!bucket)
+				return nullptr;
+
+			return &bucket->stats;
+		}
+
+		GenericAllocator::TInstance GetGenericAllocatorInstance() {
+			return gAllocator;
+		}
+	};
+
+	template<typename Threading>
+	void TaggedFreeList<Threading>::Create(size_t elementSize) {
+		SM_ASSERT(elementSize >= 16 && "Invalid element size");
+
+		globalTag.store(0, std::memory_order_relaxed);
+
+		uint8_t* node = pData;
+
+		TaggedIndex headVal;
+		headVal.p.tag = globalTag.load(std::memory_order_relaxed);
+		headVal.p.offset = GetOffset(node);
+		head.store(headVal.u);
+
+		while (true) {
+			uint8_t* next = node + elementSize;
+
+			if ((next + elementSize) <= pBufferEnd) {
+				TaggedIndex nextVal;
+				nextVal.p.tag = globalTag.load(std::memory_order_relaxed);;
+				nextVal.p.offset = GetOffset(next);
+				*((TaggedIndex*)(node)) = nextVal;
+			} else {
+				((TaggedIndex*)(node))->u = TaggedIndex::Invalid;
+
+				break;
+			}
+
+			node = next;
+			globalTag.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	template<typename Threading>
+	uint32_t TaggedFreeList<Threading>::AllocBatch(uint32_t* pOffsets, uint32_t maxCount) {
+		size_t bytesCount = (size_t)(pBufferEnd - pData);
+
+		TaggedIndex headValue;
+		headValue.u = head.load();
+
+		while (maxCount > 0 && headValue.u != TaggedIndex::Invalid) {
+			TaggedIndex nextValue = headValue;
+			uint32_t count = 0;
+
+			// Nodes are read speculatively, any concurrent change of the chain changes the head and fails the exchange
+			while (count < maxCount && nextValue.u != TaggedIndex::Invalid) {
+				size_t offset = ShiftOffset(nextValue.p.offset, offsetShift);
+
+				if (offset + sizeof(TaggedIndex) > bytesCount)
+					break;
+
+				pOffsets[count++] = nextValue.p.offset;
+				nextValue = *((TaggedIndex*)(pData + offset));
+			}
+
+			if (head.compare_exchange_strong(headValue.u, nextValue.u))
+				return count;
+		}
+
+		return 0;
+	}
+
+	namespace internal {
+		template<typename Config>
+		void TlsPoolBucket<Config>::Init(uint32_t* pCacheStack, uint32_t maxElementsNum, uint8_t maxElementsNumL0, CacheWarmupOptions warmupOptions, PoolBucket* poolBucket) {
+			SM_ASSERT(numElementsL0 == 0);
+			SM_ASSERT(numElementsL1 == 0);
+			SM_ASSERT(pBucket == nullptr);
+			SM_ASSERT(pBucketData == nullptr);
+			SM_ASSERT(pStorageL1 == nullptr);
+			SM_ASSERT(maxElementsCount == 0);
+			SM_ASSERT(maxElementsNum >= maxElementsNumL0 + 2u);
+
+			// The second level stack keeps room for the first level, which is flushed there on destruction
+			pStorageL1 = pCacheStack;
+			numElementsL1 = 0;
+			numElementsL0 = 0;
+			maxElementsL0 = maxElementsNumL0;
+			maxElementsCount = (maxElementsNum - maxElementsNumL0);
+			pBucket = poolBucket;
+
+			SM_ASSERT(pBucket);
+
+			pBucketData = pBucket->pData;
+			offsetShift = pBucket->offsetShift;
+			flags = 0;
+
+			if (warmupOptions == CACHE_COLD)
+				return;
+
+			uint32_t num = (warmupOptions == CACHE_WARM) ? (maxElementsCount / 2) : (maxElementsCount);
+
+			// The chain is detached with a single exchange, the first element of the bucket ends up on top of the stack
+			numElementsL1 = pBucket->AllocBatch(pStorageL1, num);
+			std::reverse(pStorageL1, pStorageL1 + numElementsL1);
+
+			SM_ASSERT(GetElementsCount() <= num);
+
+			if (warmupOptions == CACHE_RESERVED)
+				flags |= CACHE_BUCKET_RESERVED;
+		}
+
+		template<typename Config>
+		void TlsPoolBucket<Config>::Destroy() {
+			for (uint32_t i = 0; i < numElementsL0; i++) {
+				pStorageL1[numElementsL1] = GetStorageL0(i);
+				numElementsL1++;
+			}
+
+			if (numElementsL1 > 0)
+				ReturnL1CacheToMaster(numElementsL1);
+
+			pStorageL1 = nullptr;
+			numElementsL0 = 0;
+			maxElementsL0 = 0;
+			numElementsL1 = 0;
+			maxElementsCount = 0;
+			offsetShift = 0;
+			flags = 0;
+			pBucket = nullptr;
+			pBucketData = nullptr;
+		}
+	}
+
+	template<typename Config>
+	typename BasicAllocator<Config>::ThreadCache BasicAllocator<Config>::emptyThreadCache;
+
+	template<typename Config>
+	typename BasicAllocator<Config>::TlsBucket BasicAllocator<Config>::emptyCacheBucket;
+
+	template<typename Config>
+	INLINE void* BasicAllocator<Config>::AllocFromCache(TlsBucket* __restrict _self) const {
+		if (_self->numElementsL0 > 0) {
+			SM_ASSERT(_self->pBucketData != nullptr);
+
+			_self->numElementsL0--;
+
+			uint32_t offset = _self->GetStorageL0(_self->numElementsL0);
+
+			return _self->pBucketData + ShiftOffset(offset, _self->offsetShift);
+		}
+
+		if (_self->numElementsL1 > 0) {
+			SM_ASSERT(_self->pBucketData != nullptr);
+			SM_ASSERT(_self->numElementsL0 == 0);
+
+			_self->numElementsL1--;
+
+			uint32_t offset = _self->pStorageL1[_self->numElementsL1];
+
+			return _self->pBucketData + ShiftOffset(offset, _self->offsetShift);
+		}
+
+		return nullptr;
+	}
+
+	template<typename Config>
+	INLINE bool BasicAllocator<Config>::IsReservedCache(const TlsBucket* __restrict _self) const {
+		return (_self->flags & internal::CACHE_BUCKET_RESERVED) != 0;
+	}
+
+	template<typename Config>
+	INLINE bool BasicAllocator<Config>::HasCacheHandoff(const TlsBucket* __restrict _self) const {
+		return (_self->flags & internal::CACHE_BUCKET_HANDOFF) != 0;
+	}
+
+	template<typename Config>
+	template<bool useCacheL0>
+	INLINE bool BasicAllocator<Config>::ReleaseToCache(TlsBucket* __restrict _self, void* _p) {
+		if (_self->maxElementsCount == 0)
+			return false;
+
+		SM_ASSERT(_self->pBucket != nullptr);
+		SM_ASSERT(_self->pBucketData != nullptr);
+
+		uint8_t* p = (uint8_t*)_p;
+
+		SM_ASSERT(p >= _self->pBucketData && p < _self->pBucket->pBufferEnd);
+
+		uint32_t offset = UnshiftOffset((size_t)(p - _self->pBucketData), _self->offsetShift);
+
+		if (useCacheL0) {
+			if (_self->numElementsL0 < _self->maxElementsL0) {
+				_self->GetStorageL0(_self->numElementsL0) = offset;
+				_self->numElementsL0++;
+
+				return true;
+			}
+		}
+
+		if (_self->numElementsL1 < _self->maxElementsCount) {
+			_self->pStorageL1[_self->numElementsL1] = offset;
+			_self->numElementsL1++;
+
+			return true;
+		}
+
+		// A reserved quota is never flushed, a surplus memory block goes back to the bucket alone
+		if (_self->flags & internal::CACHE_BUCKET_RESERVED)
+			return false;
+
+		uint32_t halfOfElements = (_self->numElementsL1 >> 1);
+
+		_self->ReturnL1CacheToMaster(halfOfElements);
+		_self->pStorageL1[_self->numElementsL1] = offset;
+		_self->numElementsL1++;
+
+		return true;
+	}
+
+	template<typename Config>
+	std::mutex& BasicAllocator<Config>::GetAllocatorsMutex() {
+		static std::mutex mutex;
+
+		return mutex;
+	}
+
+	template<typename Config>
+	std::vector<BasicAllocator<Config>*>& BasicAllocator<Config>::GetAllocators() {
+		static std::vector<BasicAllocator*>* allocators = new std::vector<BasicAllocator*>();
+
+		return *allocators;
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::StopWarmupThread(ThreadCache* cache) {
+		if (cache->pWarmupThread == nullptr)
+			return;
+
+		cache->cancelled.store(true, std::memory_order_relaxed);
+		cache->pWarmupThread->join();
+
+		delete cache->pWarmupThread;
+		cache->pWarmupThread = nullptr;
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::AbandonThreadCache() {
+		ThreadCache* cache = GetThreadCache();
+
+		GetThreadCache() = &emptyThreadCache;
+
+		if (cache != &emptyThreadCache) {
+			StopWarmupThread(cache);
+			GenericAllocator::Free(GenericAllocator::Invalid(), cache);
+		}
+
+		ThreadCacheGuard& guard = GetCacheGuard();
+
+		guard.pOwner = nullptr;
+		guard.ownerId = 0;
+	}
+
+	// Small classes which churn the most get extra first level slots, the largest classes give up as many of theirs down to one slot, so the total depth
+	// of a thread stays the same and each depth is limited by the cache size
+	template<typename Config>
+	void BasicAllocator<Config>::GetCacheDepthsL0(const uint32_t* pCacheSizes, size_t cachedBucketsCount, uint8_t* pDepths) {
+		size_t extensionBucketsCount = std::min(cachedBucketsCount, (size_t)SMM_CACHE_L0_EXTENSION_BUCKETS);
+		size_t weightsSum = 0;
+		size_t spareSlotsCount = 0;
+		size_t i;
+
+		for (i = 0; i < cachedBucketsCount; i++) {
+			pDepths[i] = (uint8_t)std::min((size_t)Config::CacheItemsCount, std::min((size_t)pCacheSizes[i], (size_t)UINT8_MAX));
+
+			if (i < extensionBucketsCount && pCacheSizes[i] != 0)
+				weightsSum += SMM_MAX_BUCKET_COUNT / (i + 1);
+			else if (pDepths[i] > 1)
+				spareSlotsCount += pDepths[i] - 1u;
+		}
+
+		size_t extensionSlotsCount = std::min((size_t)(Config::CacheExtensionSize / sizeof(uint32_t)), spareSlotsCount);
+		size_t grantedSlotsCount = 0;
+
+		if (weightsSum == 0 || extensionSlotsCount == 0)
+			return;
+
+		for (i = 0; i < extensionBucketsCount; i++) {
+			if (pCacheSizes[i] == 0)
+				continue;
+
+			size_t depth = Config::CacheItemsCount + extensionSlotsCount * (SMM_MAX_BUCKET_COUNT / (i + 1)) / weightsSum;
+
+			depth = std::min(depth, std::min((size_t)pCacheSizes[i], (size_t)UINT8_MAX));
+			grantedSlotsCount += depth - pDepths[i];
+			pDepths[i] = (uint8_t)depth;
+		}
+
+		for (i = cachedBucketsCount; i-- > extensionBucketsCount && grantedSlotsCount > 0;) {
+			if (pDepths[i] <= 1)
+				continue;
+
+			size_t takenSlotsCount = std::min(grantedSlotsCount, (size_t)pDepths[i] - 1);
+
+			pDepths[i] = (uint8_t)(pDepths[i] - takenSlotsCount);
+			grantedSlotsCount -= takenSlotsCount;
+		}
+	}
+
+	// Number of first level slots placed below the second level stack of a bucket
+	template<typename Config>
+	uint32_t BasicAllocator<Config>::GetExtensionL0(uint8_t depthL0) {
+		return (depthL0 > Config::CacheItemsCount) ? (uint32_t)(depthL0 - Config::CacheItemsCount) : 0;
+	}
+
+	template<typename Config>
+	BasicAllocator<Config>::ThreadCacheGuard::~ThreadCacheGuard() {
+		Release();
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::ThreadCacheGuard::Release() {
+		ThreadCacheGuard& guard = GetCacheGuard();
+		BasicAllocator* owner = guard.pOwner;
+
+		if (owner == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(GetAllocatorsMutex());
+		std::vector<BasicAllocator*>& allocators = GetAllocators();
+
+		// The owner might be destroyed already, its pool is gone so cached elements are dropped with it
+		if (std::find(allocators.begin(), allocators.end(), owner) != allocators.end() && owner->instanceId == guard.ownerId)
+			owner->DestroyThreadCache();
+		else
+			AbandonThreadCache();
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCache(CacheWarmupOptions warmupOptions, size_t cacheSize) {
+		return CreateThreadCache(warmupOptions, cacheSize, UINT64_MAX);
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCache(CacheWarmupOptions warmupOptions, size_t cacheSize, uint64_t bucketsMask) {
+		std::array<uint32_t, Config::MaxBucketsCount> cacheSizes;
+
+		for (size_t i = 0; i < cacheSizes.size(); i++) {
+			cacheSizes[i] = (bucketsMask & (uint64_t(1) << i)) ? (uint32_t)cacheSize : 0;
+		}
+
+		return CreateThreadCache(warmupOptions, cacheSizes.data(), cacheSizes.size());
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCache(CacheWarmupOptions warmupOptions, const uint32_t* pCacheSizes, size_t cacheSizesCount) {
+		return CreateThreadCacheBlock(warmupOptions, pCacheSizes, cacheSizesCount, false);
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCacheAsync(CacheWarmupOptions warmupOptions, size_t cacheSize) {
+		return CreateThreadCacheAsync(warmupOptions, cacheSize, UINT64_MAX);
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCacheAsync(CacheWarmupOptions warmupOptions, size_t cacheSize, uint64_t bucketsMask) {
+		std::array<uint32_t, Config::MaxBucketsCount> cacheSizes;
+
+		for (size_t i = 0; i < cacheSizes.size(); i++) {
+			cacheSizes[i] = (bucketsMask & (uint64_t(1) << i)) ? (uint32_t)cacheSize : 0;
+		}
+
+		return CreateThreadCacheAsync(warmupOptions, cacheSizes.data(), cacheSizes.size());
+	}
+
+	// Buckets of a single threaded allocator can't be filled from another thread, so its caches are warmed up in place
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCacheAsync(CacheWarmupOptions warmupOptions, const uint32_t* pCacheSizes, size_t cacheSizesCount) {
+		return CreateThreadCacheBlock(warmupOptions, pCacheSizes, cacheSizesCount, Config::Threading::IsConcurrent && warmupOptions != CACHE_COLD);
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::CreateThreadCacheBlock(CacheWarmupOptions warmupOptions, const uint32_t* pCacheSizes, size_t cacheSizesCount, bool async) {
+		ThreadCacheGuard::Release();
+
+		std::array<uint32_t, Config::MaxBucketsCount> cacheSizes;
+		std::array<uint8_t, Config::MaxBucketsCount> depthsL0;
+		size_t cachedBucketsCount = 0;
+		size_t stacksBytesCount = 0;
+		size_t i = 0;
+
+		for (i = 0; i < std::min(bucketsCount, cacheSizesCount); i++) {
+			// A second level stack holds at least two elements, so a full stack still has a half to return on release
+			cacheSizes[i] = (pCacheSizes[i] == 0) ? 0 : std::max(pCacheSizes[i], 2u);
+
+			if (cacheSizes[i] != 0)
+				cachedBucketsCount = i + 1;
+		}
+
+		// The previous cache is gone already, so the thread is left without one
+		if (cachedBucketsCount == 0)
+			return false;
+
+		GetCacheDepthsL0(cacheSizes.data(), cachedBucketsCount, depthsL0.data());
+
+		for (i = 0; i < cachedBucketsCount; i++) {
+			if (cacheSizes[i] == 0)
+				continue;
+
+			stacksBytesCount += Align((GetExtensionL0(depthsL0[i]) + cacheSizes[i] + depthsL0[i]) * sizeof(uint32_t), SMM_CACHE_LINE_SIZE);
+		}
+
+		// Buckets above the last cached one are left out of the block, lookups beyond the header fall back to the empty state
+		size_t stateBytesCount = SMM_CACHE_LINE_SIZE + cachedBucketsCount * sizeof(TlsBucket);
+		size_t handoffBytesCount = async ? stacksBytesCount : 0;
+		uint8_t* p = (uint8_t*)GenericAllocator::Alloc(gAllocator, stateBytesCount + stacksBytesCount + handoffBytesCount, SMM_CACHE_LINE_SIZE);
+
+		if (p == nullptr)
+			return false;
+
+		std::memset(p, 0, stateBytesCount);
+
+		ThreadCache* cache = (ThreadCache*)p;
+		cache->bucketsCount = (uint32_t)cachedBucketsCount;
+		cache->warmupOptions = warmupOptions;
+		cache->handoffDistance = handoffBytesCount;
+		cache->readyMask.store(0, std::memory_order_relaxed);
+		cache->cancelled.store(false, std::memory_order_relaxed);
+		cache->pWarmupThread = nullptr;
+		GetThreadCache() = cache;
+
+		uint8_t* pStack = p + stateBytesCount;
+
+		for (i = 0; i < cachedBucketsCount; i++) {
+			if (cacheSizes[i] == 0)
+				continue;
+
+			uint32_t extensionNum = GetExtensionL0(depthsL0[i]);
+			uint32_t elementsNum = cacheSizes[i] + depthsL0[i];
+			TlsBucket& bucket = cache->GetBuckets()[i];
+
+			bucket.Init((uint32_t*)pStack + extensionNum, elementsNum, depthsL0[i], async ? CACHE_COLD : warmupOptions, GetBucketByIndex(i));
+
+			if (async)
+				bucket.flags |= internal::CACHE_BUCKET_HANDOFF;
+
+			pStack += Align((extensionNum + elementsNum) * sizeof(uint32_t), SMM_CACHE_LINE_SIZE);
+		}
+
+		ThreadCacheGuard& guard = GetCacheGuard();
+
+		guard.pOwner = this;
+		guard.ownerId = instanceId;
+
+		if (!async)
+			return true;
+
+		warmupThreadsCount.fetch_add(1);
+
+		try {
+			cache->pWarmupThread = new std::thread(&BasicAllocator::WarmupThreadCache, this, cache);
+		} catch (...) {
+			WarmupThreadCache(cache);
+		}
+
+		return true;
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::WarmupThreadCache(ThreadCache* cache) {
+		for (size_t i = 0; i < cache->bucketsCount; i++) {
+			if (cache->cancelled.load(std::memory_order_relaxed) || warmupCancelled.load(std::memory_order_relaxed))
+				break;
+
+			TlsBucket& bucket = cache->GetBuckets()[i];
+
+			if ((bucket.flags & internal::CACHE_BUCKET_HANDOFF) == 0)
+				continue;
+
+			// The first slot of a handoff area holds the count, the owner thread reads it only after the bucket is published
+			uint32_t* pHandoff = (uint32_t*)((uint8_t*)bucket.pStorageL1 + cache->handoffDistance);
+			uint32_t num = (cache->warmupOptions == CACHE_WARM) ? (bucket.maxElementsCount / 2) : (bucket.maxElementsCount);
+
+			pHandoff[0] = bucket.pBucket->AllocBatch(pHandoff + 1, num);
+			cache->readyMask.fetch_or(uint64_t(1) << i, std::memory_order_release);
+		}
+
+		warmupThreadsCount.fetch_sub(1);
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::TakeCacheHandoff(TlsBucket* __restrict _self, size_t bucketIndex) {
+		ThreadCache* cache = GetThreadCache();
+
+		if ((cache->readyMask.load(std::memory_order_acquire) & (uint64_t(1) << bucketIndex)) == 0)
+			return false;
+
+		uint32_t* pHandoff = (uint32_t*)((uint8_t*)_self->pStorageL1 + cache->handoffDistance);
+		uint32_t count = pHandoff[0];
+		uint32_t takenCount = std::min(count, _self->maxElementsCount - _self->numElementsL1);
+
+		// Elements are pushed in reverse, so the first element of the bucket ends up on top of the stack
+		for (uint32_t i = 0; i < takenCount; i++) {
+			_self->pStorageL1[_self->numElementsL1 + i] = pHandoff[takenCount - i];
+		}
+
+		_self->numElementsL1 += takenCount;
+		_self->pBucket->FreeBatch(pHandoff + 1 + takenCount, count - takenCount);
+		_self->flags &= ~internal::CACHE_BUCKET_HANDOFF;
+
+		if (cache->warmupOptions == CACHE_RESERVED)
+			_self->flags |= internal::CACHE_BUCKET_RESERVED;
+
+		return (takenCount > 0);
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::DestroyThreadCache() {
+		ThreadCache* cache = GetThreadCache();
+
+		ThreadCacheGuard& guard = GetCacheGuard();
+
+		guard.pOwner = nullptr;
+		guard.ownerId = 0;
+
+		if (cache == &emptyThreadCache)
+			return;
+
+		StopWarmupThread(cache);
+
+		for (size_t i = 0; i < cache->bucketsCount; i++) {
+			TlsBucket* bucket = cache->GetBuckets() + i;
+
+			if (HasCacheHandoff(bucket))
+				TakeCacheHandoff(bucket, i);
+
+			bucket->Destroy();
+		}
+
+		GetThreadCache() = &emptyThreadCache;
+		GenericAllocator::Free(gAllocator, cache);
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::TinyBucket::Create(Atomic<uint64_t>* pMask, size_t elementsCount) {
+		pFreeMask = pMask;
+		wordsCount = (uint32_t)((elementsCount + 63) / 64);
+		hint.store(0, std::memory_order_relaxed);
+
+		for (uint32_t i = 0; i < wordsCount; i++) {
+			size_t count = std::min(elementsCount - (size_t)i * 64, (size_t)64);
+			uint64_t mask = (count == 64) ? UINT64_MAX : ((uint64_t(1) << count) - 1);
+
+			new(&pFreeMask[i]) Atomic<uint64_t>(mask);
+		}
+	}
+
+	template<typename Config>
+	uint32_t BasicAllocator<Config>::GetIoBuffers(uint64_t bucketsMask, IoVec* pBuffers, uint32_t maxBuffersCount, uint32_t firstBufferIndex) {
+		uint32_t count = 0;
+
+		for (size_t i = 0; i < bucketsCount; i++) {
+			if ((bucketsMask & (uint64_t(1) << i)) == 0)
+				continue;
+
+			if (pBuffers == nullptr) {
+				count++;
+
+				continue;
+			}
+
+			if (count >= maxBuffersCount)
+				break;
+
+			pBuffers[count].base = buckets[i].pData;
+			pBuffers[count].length = bucketSizeInBytes;
+			count++;
+		}
+
+		if (pBuffers == nullptr)
+			return count;
+
+		uint32_t bufferIndex = firstBufferIndex;
+
+		for (size_t i = 0; i < ioBufferIndices.size(); i++) {
+			if (i < bucketsCount && (bucketsMask & (uint64_t(1) << i)) != 0 && bufferIndex < firstBufferIndex + count)
+				ioBufferIndices[i] = (int32_t)bufferIndex++;
+			else
+				ioBufferIndices[i] = -1;
+		}
+
+		return count;
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::RegisterIoBuffers(int ringFd, uint64_t bucketsMask) {
+		if (ringFd < 0 || ioRingFd >= 0)
+			return false;
+
+		std::array<IoVec, Config::MaxBucketsCount> buffers;
+		uint32_t count = GetIoBuffers(bucketsMask, buffers.data(), (uint32_t)buffers.size(), 0);
+
+		if (count == 0)
+			return false;
+
+		if (!internal::RegisterIoRing(ringFd, buffers.data(), count)) {
+			ioBufferIndices.fill(-1);
+
+			return false;
+		}
+
+		ioRingFd = ringFd;
+
+		return true;
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::UnregisterIoBuffers() {
+		if (ioRingFd < 0)
+			return false;
+
+		bool r = internal::UnregisterIoRing(ioRingFd);
+
+		ioRingFd = -1;
+		ioBufferIndices.fill(-1);
+
+		return r;
+	}
+
+	template<typename Config>
+	internal::HandleHeap* BasicAllocator<Config>::GetHandleHeap() {
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (SM_LIKELY(heap != nullptr))
+			return heap;
+
+		internal::HandleHeap* expected = nullptr;
+
+		heap = new internal::HandleHeap();
+
+		if (!pHandleHeap.compare_exchange_strong(expected, heap, std::memory_order_acq_rel)) {
+			delete heap;
+
+			return expected;
+		}
+
+		return heap;
+	}
+
+	template<typename Config>
+	uint64_t BasicAllocator<Config>::AllocHandle(size_t bytesCount) {
+		internal::HandleHeap* heap = GetHandleHeap();
+		size_t classIndex = (bytesCount == 0) ? 0 : Config::GetSizeClass(bytesCount, 0);
+
+		std::lock_guard<std::mutex> lock(heap->mutex);
+
+		uint32_t index = heap->freeEntry;
+
+		if (index == SMM_INVALID_HANDLE_SLOT) {
+			if (heap->entries.size() >= SMM_INVALID_HANDLE_SLOT)
+				return 0;
+
+			index = (uint32_t)heap->entries.size();
+		}
+
+		internal::HandlePage* page = nullptr;
+		uint32_t slot = 0;
+		uint8_t* p = nullptr;
+
+		if (classIndex < bucketsCount) {
+			internal::HandleClass& handleClass = heap->classes[classIndex];
+			uint32_t elementSize = GetBucketElementSize(classIndex);
+			size_t pageIndex = internal::FindHandlePage(handleClass);
+
+			if (pageIndex == handleClass.pages.size()) {
+				page = internal::CreateHandlePage(gAllocator, elementSize);
+
+				if (page == nullptr)
+					return 0;
+
+				handleClass.pages.push_back(page);
+			}
+
+			page = handleClass.pages[pageIndex];
+			p = internal::AllocHandleSlot(page, elementSize, index, &slot);
+		} else {
+			p = (uint8_t*)GenericAllocator::Alloc(gAllocator, bytesCount, 16);
+
+			if (p == nullptr)
+				return 0;
+		}
+
+		if (index == heap->entries.size()) {
+			internal::HandleEntry newEntry;
+
+			std::memset(&newEntry, 0, sizeof(internal::HandleEntry));
+			heap->entries.push_back(newEntry);
+		} else {
+			heap->freeEntry = heap->entries[index].nextFree;
+		}
+
+		internal::HandleEntry& entry = heap->entries[index];
+
+		entry.p = p;
+		entry.pPage = page;
+		entry.bytesCount = bytesCount;
+		entry.slot = slot;
+		entry.locksCount = 0;
+		entry.nextFree = SMM_INVALID_HANDLE_SLOT;
+		entry.generation++;
+
+		return ((uint64_t)entry.generation << 32) | index;
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::FreeHandle(uint64_t handle) {
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (heap == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(heap->mutex);
+		internal::HandleEntry* entry = heap->Find(handle);
+
+		if (entry == nullptr)
+			return;
+
+		if (entry->pPage != nullptr) {
+			size_t classIndex = (entry->bytesCount == 0) ? 0 : Config::GetSizeClass(entry->bytesCount, 0);
+			internal::HandleClass& handleClass = heap->classes[classIndex];
+
+			internal::FreeHandleSlot(entry->pPage, GetBucketElementSize(classIndex), entry->slot);
+
+			for (size_t i = 0; i < handleClass.firstFreePage; i++) {
+				if (handleClass.pages[i] == entry->pPage) {
+					handleClass.firstFreePage = i;
+
+					break;
+				}
+			}
+		} else {
+			GenericAllocator::Free(gAllocator, entry->p);
+		}
+
+		entry->p = nullptr;
+		entry->pPage = nullptr;
+		entry->generation++;
+		entry->nextFree = heap->freeEntry;
+		heap->freeEntry = (uint32_t)handle;
+	}
+
+	template<typename Config>
+	void* BasicAllocator<Config>::LockHandle(uint64_t handle) {
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (heap == nullptr)
+			return nullptr;
+
+		std::lock_guard<std::mutex> lock(heap->mutex);
+		internal::HandleEntry* entry = heap->Find(handle);
+
+		if (entry == nullptr)
+			return nullptr;
+
+		entry->locksCount++;
+
+		return entry->p;
+	}
+
+	template<typename Config>
+	void BasicAllocator<Config>::UnlockHandle(uint64_t handle) {
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (heap == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(heap->mutex);
+		internal::HandleEntry* entry = heap->Find(handle);
+
+		if (entry != nullptr && entry->locksCount > 0)
+			entry->locksCount--;
+	}
+
+	template<typename Config>
+	size_t BasicAllocator<Config>::GetHandleSize(uint64_t handle) {
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (heap == nullptr)
+			return 0;
+
+		std::lock_guard<std::mutex> lock(heap->mutex);
+		internal::HandleEntry* entry = heap->Find(handle);
+
+		if (entry == nullptr)
+			return 0;
+
+		return entry->bytesCount;
 	}
 
-	INLINE void* Allocator::AllocFromCache(internal::TlsPoolBucket* __restrict _self) const {
-		if (_self->numElementsL0 > 0) {
-			SM_ASSERT(_self->pBucketData != nullptr);
+	template<typename Config>
+	size_t BasicAllocator<Config>::Compact(uint64_t budgetMicroseconds) {
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (heap == nullptr || bucketsCount == 0)
+			return 0;
+
+		std::lock_guard<std::mutex> lock(heap->mutex);
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budgetMicroseconds);
+		size_t releasedBytesCount = 0;
+		uint32_t stepsCount = 0;
+		uint32_t passMovesCount;
+
+		// An unlimited budget repeats the passes until nothing moves anymore
+		do {
+			passMovesCount = 0;
+
+			// Classes are visited round-robin, so a small budget still makes progress on every class across calls
+			for (size_t n = 0; n < bucketsCount; n++) {
+				size_t classIndex = heap->compactClassIndex;
+				internal::HandleClass& handleClass = heap->classes[classIndex];
+				std::vector<internal::HandlePage*>& pages = handleClass.pages;
+				uint32_t elementSize = GetBucketElementSize(classIndex);
+
+				for (size_t i = 0; i < pages.size();) {
+					if (pages[i]->usedCount == 0) {
+						GenericAllocator::Free(gAllocator, pages[i]);
+						pages.erase(pages.begin() + i);
+						releasedBytesCount += SMM_HANDLE_PAGE_SIZE;
+					} else {
+						i++;
+					}
+				}
 
-			_self->numElementsL0--;
+				handleClass.firstFreePage = 0;
+
+				// Live elements of the last pages move into free slots of the first pages, pages with locked elements stay in place
+				for (size_t i = pages.size(); i-- > 1;) {
+					internal::HandlePage* source = pages[i];
+
+					for (uint32_t slot = 0; slot < source->capacity && source->usedCount > 0; slot++) {
+						// Scanned slots count toward the budget as well as moves, so sparse or locked pages can't overrun it
+						if (budgetMicroseconds > 0 && (++stepsCount % SMM_COMPACT_CLOCK_INTERVAL) == 0 && std::chrono::steady_clock::now() >= deadline)
+							return releasedBytesCount;
+
+						uint32_t owner = source->pOwners[slot];
+
+						if (owner == SMM_INVALID_HANDLE_SLOT || heap->entries[owner].locksCount > 0)
+							continue;
+
+						size_t pageIndex = internal::FindHandlePage(handleClass);
+
+						if (pageIndex >= i)
+							break;
+
+						internal::HandleEntry& entry = heap->entries[owner];
+						uint8_t* p = internal::AllocHandleSlot(pages[pageIndex], elementSize, owner, &entry.slot);
+
+						std::memcpy(p, entry.p, elementSize);
+						internal::FreeHandleSlot(source, elementSize, slot);
+						entry.p = p;
+						entry.pPage = pages[pageIndex];
+						passMovesCount++;
+					}
+
+					if (source->usedCount > 0)
+						continue;
+
+					GenericAllocator::Free(gAllocator, source);
+					pages.erase(pages.begin() + i);
+					releasedBytesCount += SMM_HANDLE_PAGE_SIZE;
+				}
+
+				handleClass.firstFreePage = 0;
+				heap->compactClassIndex = (classIndex + 1) % bucketsCount;
+
+				if (budgetMicroseconds > 0 && std::chrono::steady_clock::now() >= deadline)
+					break;
+			}
+		} while (budgetMicroseconds == 0 && passMovesCount > 0);
+
+		return releasedBytesCount;
+	}
+
+	template<typename Config>
+	uint8_t* BasicAllocator<Config>::AllocateArena(size_t bytesCount, size_t alignment) {
+		ArenaDeleter& deleter = pBuffer.get_deleter();
+
+		return internal::AllocateArena(gAllocator, bytesCount, alignment, options, &deleter.mappedBytesCount, &deleter.fd);
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::LockArena(size_t bytesCount) {
+		if (!internal::LockArena(pBuffer.get(), bytesCount))
+			return false;
+
+		pBuffer.get_deleter().lockedBytesCount = bytesCount;
+
+		return true;
+	}
+
+	template<typename Config>
+	size_t BasicAllocator<Config>::GetTinyBucketsBytesCount() const {
+		size_t masksBytesCount = 0;
 
-			uint32_t offset = _self->storageL0[_self->numElementsL0];
+		for (size_t i = 0; i < tinyBuckets.size(); i++) {
+			size_t elementsCount = bucketSizeInBytes / (size_t(4) << i);
 
-			return _self->pBucketData + offset;
+			masksBytesCount += ((elementsCount + 63) / 64) * sizeof(Atomic<uint64_t>);
 		}
 
-		if (_self->numElementsL1 > 0) {
-			SM_ASSERT(_self->pBucketData != nullptr);
-			SM_ASSERT(_self->numElementsL0 == 0);
+		return bucketSizeInBytes * tinyBuckets.size() + masksBytesCount;
+	}
 
-			_self->numElementsL1--;
+	template<typename Config>
+	void BasicAllocator<Config>::CreateTinyBuckets(uint8_t* pData) {
+		size_t dataBytesCount = bucketSizeInBytes * tinyBuckets.size();
+		Atomic<uint64_t>* pMask = (Atomic<uint64_t>*)(pData + dataBytesCount);
 
-			uint32_t offset = _self->pStorageL1[_self->numElementsL1];
+		for (size_t i = 0; i < tinyBuckets.size(); i++) {
+			TinyBucket& tinyBucket = tinyBuckets[i];
+			tinyBucket.elementSize = uint32_t(4) << i;
+			tinyBucket.pData = pData + i * bucketSizeInBytes;
+			tinyBucket.pBufferEnd = tinyBucket.pData + bucketSizeInBytes;
 
-			return _self->pBucketData + offset;
+			size_t elementsCount = bucketSizeInBytes / tinyBucket.elementSize;
+
+			tinyBucket.Create(pMask, elementsCount);
+			pMask += tinyBucket.wordsCount;
 		}
 
-		return nullptr;
+		pTinyBuffer = pData;
+		pTinyBufferEnd = pData + dataBytesCount;
 	}
 
-	template<bool useCacheL0>
-	INLINE bool Allocator::ReleaseToCache(internal::TlsPoolBucket* __restrict _self, void* _p) {
-		if (_self->maxElementsCount == 0)
+	template<typename Config>
+	void BasicAllocator<Config>::CreateBuckets(size_t firstBucketIndex, size_t lastBucketIndex) {
+		for (size_t i = firstBucketIndex; i < lastBucketIndex; i++) {
+			buckets[i].Create(GetBucketElementSize(i));
+		}
+	}
+
+	template<typename Config>
+	BasicAllocator<Config>::BasicAllocator(GenericAllocator::TInstance allocator) : bucketsCount(0), bucketSizeInBytes(0), pBufferEnd(nullptr), ioRingFd(-1), options(ALLOCATOR_DEFAULT), pBuffer(nullptr, ArenaDeleter(allocator)), pTinyBuffer(nullptr), pTinyBufferEnd(nullptr), gAllocator(allocator), pHandleHeap(nullptr), warmupThreadsCount(0), warmupCancelled(false) {
+		ioBufferIndices.fill(-1);
+
+		static std::atomic<uint64_t> instancesCount(0);
+
+		instanceId = instancesCount.fetch_add(1, std::memory_order_relaxed) + 1;
+
+		std::lock_guard<std::mutex> lock(GetAllocatorsMutex());
+
+		GetAllocators().push_back(this);
+	}
+
+	template<typename Config>
+	BasicAllocator<Config>::~BasicAllocator() {
+		// Warmup threads of other threads' caches still fill them from the pool, they are stopped before it goes away
+		warmupCancelled.store(true);
+
+		while (warmupThreadsCount.load() > 0) {
+			std::this_thread::yield();
+		}
+
+		// A ring which still has the buckets registered would keep pinned pages of the unmapped arena
+		if (ioRingFd >= 0)
+			UnregisterIoBuffers();
+
+		std::lock_guard<std::mutex> lock(GetAllocatorsMutex());
+		std::vector<BasicAllocator*>& allocators = GetAllocators();
+
+		allocators.erase(std::remove(allocators.begin(), allocators.end(), this), allocators.end());
+
+		if (GetCacheGuard().pOwner == this)
+			AbandonThreadCache();
+
+		internal::HandleHeap* heap = pHandleHeap.load(std::memory_order_acquire);
+
+		if (heap == nullptr)
+			return;
+
+		for (size_t i = 0; i < heap->entries.size(); i++) {
+			internal::HandleEntry& entry = heap->entries[i];
+
+			if ((entry.generation & 1) != 0 && entry.pPage == nullptr)
+				GenericAllocator::Free(gAllocator, entry.p);
+		}
+
+		for (size_t i = 0; i < heap->classes.size(); i++) {
+			for (size_t j = 0; j < heap->classes[i].pages.size(); j++) {
+				GenericAllocator::Free(gAllocator, heap->classes[i].pages[j]);
+			}
+		}
+
+		delete heap;
+	}
+
+	inline int GetNextPow2(uint32_t n) {
+		n -= 1;
+		n |= n >> 16;
+		n |= n >> 8;
+		n |= n >> 4;
+		n |= n >> 2;
+		n |= n >> 1;
+
+		return n + 1;
+	}
+
+	template<typename Config>
+	bool BasicAllocator<Config>::Init(uint32_t _bucketsCount, size_t _bucketSizeInBytes, uint32_t _options, uint32_t layout) {
+		if (bucketsCount > 0)
 			return false;
 
-		SM_ASSERT(_self->pBucket != nullptr);
-		SM_ASSERT(_self->pBucketData != nullptr);
+		// The caller sees other compile-time values than the allocator is built with
+		if (layout != GetLayout())
+			return false;
 
-		uint8_t* p = (uint8_t*)_p;
+		SM_ASSERT(_bucketsCount > 0 && _bucketsCount <= Config::MaxBucketsCount);
 
-		SM_ASSERT(p >= _self->pBucketData && p < _self->pBucket->pBufferEnd);
+		if (_bucketsCount == 0 || _bucketsCount > Config::MaxBucketsCount)
+			return false;
 
-		uint32_t offset = (uint32_t)(p - _self->pBucketData);
+		bucketsCount = _bucketsCount;
+		options = _options;
 
-		if (useCacheL0) {
-			if (_self->numElementsL0 < SMM_MAX_CACHE_ITEMS_COUNT) {
-				_self->storageL0[_self->numElementsL0] = offset;
-				_self->numElementsL0++;
+		size_t alignmentMax = GetNextPow2(GetBucketElementSize(bucketsCount - 1));
 
-				return true;
+		bucketSizeInBytes = Align(_bucketSizeInBytes, alignmentMax);
+
+		size_t i = 0;
+
+		for (i = 0; i < bucketsDataBegin.size(); i++) {
+			bucketsDataBegin[i] = nullptr;
+		}
+
+		size_t totalBytesCount = bucketSizeInBytes * bucketsCount;
+
+		// Tiny classes follow the buckets, so they share the backing file and the locked pages of the arena
+		size_t tinyBytesCount = (options & ALLOCATOR_TINY_CLASSES) ? GetTinyBucketsBytesCount() : 0;
+
+		pBuffer.reset(AllocateArena(totalBytesCount + tinyBytesCount, alignmentMax));
+
+		if (!pBuffer) {
+			bucketsCount = 0;
+
+			return false;
+		}
+
+		// Exclusive end, the tiny classes start right at it and must not pass as bucket elements
+		pBufferEnd = pBuffer.get() + totalBytesCount;
+
+		for (i = 0; i < bucketsCount; i++) {
+			PoolBucket& bucket = buckets[i];
+			bucket.pData = pBuffer.get() + i * bucketSizeInBytes;
+
+			SM_ASSERT(IsAligned((size_t)bucket.pData, GetNextPow2(GetBucketElementSize(i))) && "Alignment failed");
+
+			#ifdef SMMALLOC_WIDE_OFFSETS
+				bucket.offsetShift = (uint8_t)FindFirstSet(GetBucketElementSize(i));
+			#endif
+
+			// Elements past the range of 32-bit offsets are left unused
+			uint64_t maxBucketSize = (uint64_t)UINT32_MAX << bucket.offsetShift;
+
+			bucket.pBufferEnd = bucket.pData + (size_t)std::min((uint64_t)bucketSizeInBytes, maxBucketSize);
+			bucketsDataBegin[i] = bucket.pData;
+		}
+
+		size_t threadsCount = 1;
+
+		if (options & ALLOCATOR_PARALLEL_INIT) {
+			threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+			threadsCount = std::min(threadsCount, std::min(bucketsCount, (size_t)SMM_MAX_INIT_THREADS_COUNT));
+		}
+
+		std::vector<std::thread> threads;
+
+		for (i = 1; i < threadsCount; i++) {
+			size_t firstBucketIndex = (bucketsCount * i) / threadsCount;
+			size_t lastBucketIndex = (bucketsCount * (i + 1)) / threadsCount;
+
+			try {
+				threads.emplace_back(&BasicAllocator::CreateBuckets, this, firstBucketIndex, lastBucketIndex);
+			} catch (...) {
+				CreateBuckets(firstBucketIndex, lastBucketIndex);
 			}
 		}
 
-		if (_self->numElementsL1 < _self->maxElementsCount) {
-			_self->pStorageL1[_self->numElementsL1] = offset;
-			_self->numElementsL1++;
+		CreateBuckets(0, bucketsCount / threadsCount);
 
-			return true;
+		for (i = 0; i < threads.size(); i++) {
+			threads[i].join();
 		}
 
-		uint32_t halfOfElements = (_self->numElementsL1 >> 1);
+		if (options & ALLOCATOR_TINY_CLASSES)
+			CreateTinyBuckets(pBuffer.get() + totalBytesCount);
 
-		_self->ReturnL1CacheToMaster(halfOfElements);
-		_self->pStorageL1[_self->numElementsL1] = offset;
-		_self->numElementsL1++;
+		if ((options & ALLOCATOR_LOCKED) && !LockArena(totalBytesCount + tinyBytesCount)) {
+			bucketsCount = 0;
+
+			return false;
+		}
 
 		return true;
 	}
+
+	typedef BasicAllocator<DefaultConfig> Allocator;
+
+	// The library carries the default instantiation, other configurations are instantiated by their users
+	extern template class BasicAllocator<DefaultConfig>;
+
+	template<size_t bytesCount, size_t alignment, typename Config>
+	INLINE void* Alloc(BasicAllocator<Config>* allocator) {
+		return allocator->template AllocFixed<bytesCount, alignment>();
+	}
+
+	template<size_t bytesCount, typename Config>
+	INLINE void* Alloc(BasicAllocator<Config>* allocator) {
+		return allocator->template AllocFixed<bytesCount, 0>();
+	}
+
+	template<size_t bytesCount, typename Config>
+	INLINE void Free(BasicAllocator<Config>* allocator, void* p) {
+		allocator->template FreeFixed<bytesCount>(p);
+	}
+
+	class Chain {
+		private:
+
+		struct Segment {
+			Segment* pNext;
+			uint32_t offset;
+			uint32_t length;
+
+			INLINE uint8_t* GetData() {
+				return (uint8_t*)(this + 1);
+			}
+		};
+
+		static_assert(sizeof(Segment) == 16, "Chain segment header must preserve 16 bytes alignment of the payload");
+
+		Allocator* pAllocator;
+		Segment* pHead;
+		Segment* pTail;
+		Segment* pReserved;
+		size_t length;
+		uint32_t segmentsCount;
+		uint32_t segmentCapacity;
+
+		Segment* AppendSegment();
+		void ReleaseHead();
+
+		public:
+
+		Chain(Allocator* allocator, size_t segmentSize);
+		~Chain();
+
+		void* Reserve(size_t* pAvailable);
+		bool Commit(size_t bytesCount);
+		size_t Append(const void* pData, size_t bytesCount);
+		size_t Consume(size_t bytesCount);
+		void Clear();
+		uint32_t GetIoVecs(IoVec* pBuffers, uint32_t maxBuffersCount) const;
+
+		INLINE size_t GetLength() const {
+			return length;
+		}
+
+		INLINE uint32_t GetSegmentsCount() const {
+			return segmentsCount;
+		}
+
+		INLINE uint32_t GetSegmentCapacity() const {
+			return segmentCapacity;
+		}
+
+		INLINE Allocator* GetAllocator() const {
+			return pAllocator;
+		}
+	};
 }
 
 #define SMMALLOC_CSTYLE_FUNCS
 
 #ifdef SMMALLOC_CSTYLE_FUNCS
-	#define SMMALLOC_DLL
+	#ifndef SMMALLOC_STATIC_LIBRARY
+		#define SMMALLOC_DLL
+	#endif
+
+	// The library itself emits out-of-line definitions, so static archives carry every entry point for direct calls
+	#ifdef SMMALLOC_EXPORTS
+		#if defined(_WIN32) && defined(SMMALLOC_DLL)
+			#define SMMALLOC_API __declspec(dllexport)
+		#elif defined(__GNUC__)
+			#define SMMALLOC_API extern __attribute__((visibility("default")))
+		#else
+			#define SMMALLOC_API extern
+		#endif
 
-	#if defined(_WIN32) && defined(SMMALLOC_DLL)
-		#define SMMALLOC_API __declspec(dllexport)
+		#define SMMALLOC_API_INLINE
 	#else
-		#define SMMALLOC_API extern
+		// Other translation units get private inline copies, so the exported symbols have a single definition
+		#define SMMALLOC_API static
+		#define SMMALLOC_API_INLINE INLINE
 	#endif
 
 	#ifdef __cplusplus
@@ -615,8 +2504,13 @@ namespace sm {
 	#endif
 
 	typedef sm::Allocator* sm_allocator;
+	typedef sm::IoVec sm_iovec;
+	typedef sm::Chain* sm_chain;
+	typedef uint64_t sm_handle;
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_allocator_destroy(sm_allocator allocator);
 
-	SMMALLOC_API INLINE sm_allocator sm_allocator_create(uint32_t bucketsCount, size_t bucketSizeInBytes) {
+	SMMALLOC_API SMMALLOC_API_INLINE sm_allocator sm_allocator_create_ex(uint32_t bucketsCount, size_t bucketSizeInBytes, uint32_t options) {
 		sm::GenericAllocator::TInstance instance = sm::GenericAllocator::Create();
 
 		if (!sm::GenericAllocator::IsValid(instance))
@@ -629,45 +2523,93 @@ namespace sm {
 		void* pBuffer = sm::GenericAllocator::Alloc(instance, sizeof(sm::Allocator), align);
 
 		sm::Allocator* allocator = new(pBuffer) sm::Allocator(instance);
-		allocator->Init(bucketsCount, bucketSizeInBytes);
+
+		if (!allocator->Init(bucketsCount, bucketSizeInBytes, options)) {
+			sm_allocator_destroy(allocator);
+
+			return nullptr;
+		}
 
 		return allocator;
 	}
 
-	SMMALLOC_API INLINE void sm_allocator_destroy(sm_allocator allocator) {
+	SMMALLOC_API SMMALLOC_API_INLINE sm_allocator sm_allocator_create(uint32_t bucketsCount, size_t bucketSizeInBytes) {
+		return sm_allocator_create_ex(bucketsCount, bucketSizeInBytes, sm::ALLOCATOR_DEFAULT);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_allocator_destroy(sm_allocator allocator) {
 		if (allocator == nullptr)
 			return;
 
 		sm::GenericAllocator::TInstance instance = allocator->GetGenericAllocatorInstance();
-		allocator->~Allocator();
+		allocator->~BasicAllocator();
 
 		sm::GenericAllocator::Free(instance, allocator);
 		sm::GenericAllocator::Destroy(instance);
 	}
 
-	SMMALLOC_API INLINE void sm_allocator_thread_cache_create(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, size_t cacheSize) {
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_thread_cache_create(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, size_t cacheSize) {
 		if (allocator == nullptr)
-			return;
+			return false;
 
-		allocator->CreateThreadCache(warmupOptions, cacheSize);
+		return allocator->CreateThreadCache(warmupOptions, cacheSize);
 	}
 
-	SMMALLOC_API INLINE void sm_allocator_thread_cache_destroy(sm_allocator allocator) {
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_thread_cache_create_ex(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, size_t cacheSize, uint64_t bucketsMask) {
+		if (allocator == nullptr)
+			return false;
+
+		return allocator->CreateThreadCache(warmupOptions, cacheSize, bucketsMask);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_thread_cache_create_sizes(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, const uint32_t* cacheSizes, uint32_t cacheSizesCount) {
+		if (allocator == nullptr || cacheSizes == nullptr)
+			return false;
+
+		return allocator->CreateThreadCache(warmupOptions, cacheSizes, cacheSizesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_thread_cache_create_async(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, size_t cacheSize) {
+		if (allocator == nullptr)
+			return false;
+
+		return allocator->CreateThreadCacheAsync(warmupOptions, cacheSize);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_thread_cache_create_async_ex(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, size_t cacheSize, uint64_t bucketsMask) {
+		if (allocator == nullptr)
+			return false;
+
+		return allocator->CreateThreadCacheAsync(warmupOptions, cacheSize, bucketsMask);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_thread_cache_create_async_sizes(sm_allocator allocator, sm::CacheWarmupOptions warmupOptions, const uint32_t* cacheSizes, uint32_t cacheSizesCount) {
+		if (allocator == nullptr || cacheSizes == nullptr)
+			return false;
+
+		return allocator->CreateThreadCacheAsync(warmupOptions, cacheSizes, cacheSizesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_allocator_thread_cache_destroy(sm_allocator allocator) {
 		if (allocator == nullptr)
 			return;
 
 		allocator->DestroyThreadCache();
 	}
 
-	SMMALLOC_API INLINE void* sm_malloc(sm_allocator allocator, size_t bytesCount, size_t alignment) {
+	SMMALLOC_API SMMALLOC_API_INLINE void* sm_malloc(sm_allocator allocator, size_t bytesCount, size_t alignment) {
 		return allocator->Alloc(bytesCount, alignment);
 	}
 
-	SMMALLOC_API INLINE void sm_free(sm_allocator allocator, void* p) {
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_free(sm_allocator allocator, void* p) {
 		allocator->Free(p);
 	}
 
-	SMMALLOC_API INLINE void sm_free_batch(sm_allocator allocator, void** batch, size_t length) {
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_free_wipe(sm_allocator allocator, void* p) {
+		allocator->FreeWipe(p);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_free_batch(sm_allocator allocator, void** batch, size_t length) {
 		void* p;
 		size_t i;
 
@@ -681,18 +2623,147 @@ namespace sm {
 		}
 	}
 
-	SMMALLOC_API INLINE void* sm_realloc(sm_allocator allocator, void* p, size_t bytesCount, size_t alignment) {
+	SMMALLOC_API SMMALLOC_API_INLINE void* sm_realloc(sm_allocator allocator, void* p, size_t bytesCount, size_t alignment) {
 		return allocator->Realloc(p, bytesCount, alignment);
 	}
 
-	SMMALLOC_API INLINE size_t sm_msize(sm_allocator allocator, void* p) {
+	SMMALLOC_API SMMALLOC_API_INLINE void* sm_expand(sm_allocator allocator, void* p, size_t bytesCount) {
+		return allocator->Expand(p, bytesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_good_size(sm_allocator allocator, size_t bytesCount) {
+		return allocator->GetGoodSize(bytesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void* sm_grow(sm_allocator allocator, void* p, size_t usedBytes, size_t bytesCount, size_t* capacity) {
+		return allocator->Grow(p, usedBytes, bytesCount, capacity);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_msize(sm_allocator allocator, void* p) {
 		return allocator->GetUsableSize(p);
 	}
 
-	SMMALLOC_API INLINE int32_t sm_mbucket(sm_allocator allocator, void* p) {
+	SMMALLOC_API SMMALLOC_API_INLINE int32_t sm_mbucket(sm_allocator allocator, void* p) {
 		return allocator->GetBucketIndex(p);
 	}
 
+	SMMALLOC_API SMMALLOC_API_INLINE uint32_t sm_allocator_io_buffers(sm_allocator allocator, uint64_t bucketsMask, sm_iovec* buffers, uint32_t maxBuffersCount, uint32_t firstBufferIndex) {
+		if (allocator == nullptr)
+			return 0;
+
+		return allocator->GetIoBuffers(bucketsMask, buffers, maxBuffersCount, firstBufferIndex);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_io_register(sm_allocator allocator, int ringFd, uint64_t bucketsMask) {
+		if (allocator == nullptr)
+			return false;
+
+		return allocator->RegisterIoBuffers(ringFd, bucketsMask);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_allocator_io_unregister(sm_allocator allocator) {
+		if (allocator == nullptr)
+			return false;
+
+		return allocator->UnregisterIoBuffers();
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_mbuffer(sm_allocator allocator, void* p, uint32_t* bufferIndex, size_t* offset) {
+		return allocator->GetIoBuffer(p, bufferIndex, offset);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE int sm_allocator_arena_fd(sm_allocator allocator, size_t* arenaSize) {
+		if (allocator == nullptr)
+			return -1;
+
+		return allocator->GetArenaFd(arenaSize);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_mblock(sm_allocator allocator, void* p, int* fd, size_t* offset, size_t* length) {
+		return allocator->GetArenaBlock(p, fd, offset, length);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE sm_handle sm_halloc(sm_allocator allocator, size_t bytesCount) {
+		return allocator->AllocHandle(bytesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_hfree(sm_allocator allocator, sm_handle handle) {
+		allocator->FreeHandle(handle);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void* sm_hlock(sm_allocator allocator, sm_handle handle) {
+		return allocator->LockHandle(handle);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_hunlock(sm_allocator allocator, sm_handle handle) {
+		allocator->UnlockHandle(handle);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_hsize(sm_allocator allocator, sm_handle handle) {
+		return allocator->GetHandleSize(handle);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_compact(sm_allocator allocator, uint64_t budgetMicroseconds) {
+		if (allocator == nullptr)
+			return 0;
+
+		return allocator->Compact(budgetMicroseconds);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE sm_chain sm_chain_create(sm_allocator allocator, size_t segmentSize) {
+		if (allocator == nullptr)
+			return nullptr;
+
+		void* pBuffer = allocator->Alloc(sizeof(sm::Chain), __alignof(sm::Chain));
+
+		if (pBuffer == nullptr)
+			return nullptr;
+
+		return new(pBuffer) sm::Chain(allocator, segmentSize);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_chain_destroy(sm_chain chain) {
+		if (chain == nullptr)
+			return;
+
+		sm::Allocator* allocator = chain->GetAllocator();
+		chain->~Chain();
+
+		allocator->Free(chain);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_chain_append(sm_chain chain, const void* data, size_t bytesCount) {
+		return chain->Append(data, bytesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void* sm_chain_reserve(sm_chain chain, size_t* available) {
+		return chain->Reserve(available);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE bool sm_chain_commit(sm_chain chain, size_t bytesCount) {
+		return chain->Commit(bytesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_chain_consume(sm_chain chain, size_t bytesCount) {
+		return chain->Consume(bytesCount);
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE void sm_chain_clear(sm_chain chain) {
+		chain->Clear();
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE size_t sm_chain_length(sm_chain chain) {
+		return chain->GetLength();
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE uint32_t sm_chain_segments(sm_chain chain) {
+		return chain->GetSegmentsCount();
+	}
+
+	SMMALLOC_API SMMALLOC_API_INLINE uint32_t sm_chain_iovecs(sm_chain chain, sm_iovec* buffers, uint32_t maxBuffersCount) {
+		return chain->GetIoVecs(buffers, maxBuffersCount);
+	}
+
 	#ifdef __cplusplus
 	}
 	#endif